@@ -13,7 +13,9 @@
 #define DataFile_h
 
 #include <string>
+#include <string_view>
 #include <memory>
+#include <unordered_map>
 
 class DataFile
 {
@@ -72,6 +74,12 @@ public:
     void SetIndex(char *index) { m_Index = index; }
     std::string GetPathName() { return m_PathName; }
 
+    // optional index of the first occurrence of every token so that searches from the start do not scan the data
+    // anything that changes the data (including SetRawData and Replace) drops the index and searches go back to scanning
+    // so it needs building again after the data has been changed
+    void BuildParameterIndex();
+    bool HasParameterIndex() const { return m_ParameterIndexValid; }
+
     // probably mostly for internal use
     // read the next ASCII token from the current index and bump index
     bool FindParameter(const char * const param, bool searchFromStart = true);
@@ -144,6 +152,9 @@ private:
     double m_RangeControl = false;
     size_t m_Size = 0;
     std::string m_PathName;
+    std::unordered_map<std::string_view, size_t> m_ParameterIndex; // token to offset of its first occurrence
+    bool m_ParameterIndexValid = false;
+    void InvalidateParameterIndex();
 #if defined(_WIN32) || defined(WIN32)
     // provide Windows specific wchar versions
     bool ReadFile(const std::wstring &name);
@@ -79,6 +79,7 @@ void GAParametersDialog::setEditorText(const QString &newEditorText)
     DataFile dataFile;
     std::string decodedData(newEditorText.toStdString());
     dataFile.SetRawData(decodedData.c_str(), decodedData.size());
+    dataFile.BuildParameterIndex();
 
     static const std::vector<std::string> crossoverType = {"OnePoint", "Average"};
     static const std::vector<std::string> parentSelection = {"UniformSelection", "RankBasedSelection", "SqrtBasedSelection", "GammaBasedSelection"};
@@ -58,10 +58,12 @@ void DataFile::SetRawData(const char *string, size_t stringLen)
     m_FileData = std::make_unique<char[]>(m_Size);
     memcpy(m_FileData.get(), string, m_Size);
     m_Index = m_FileData.get();
+    InvalidateParameterIndex();
 }
 
 void DataFile::ClearData()
 {
+    InvalidateParameterIndex();
     m_Size = 0;
     m_FileData.reset();
     m_Index = nullptr;
@@ -113,6 +115,7 @@ size_t DataFile::Replace(const char *oldString, size_t oldLen, const char *newSt
     }
     assert(size_t(destPtr - newBuffer.get()) == newSize);
     *destPtr = 0;
+    InvalidateParameterIndex();
     m_FileData = std::move(newBuffer);
     m_Size = newSize;
     return count;
@@ -145,6 +148,7 @@ bool DataFile::ReadFile(const std::string &name)
         exit(1);
     }
     if (error) return true;
+    InvalidateParameterIndex();
     m_FileData = std::make_unique<char[]>(size_t(fileStat.st_size) + 1);
     m_Index = m_FileData.get();
     m_Size = size_t(fileStat.st_size);
@@ -250,6 +254,7 @@ bool DataFile::ReadFile(const std::wstring &name)
         exit(1);
     }
     if (error) return true;
+    InvalidateParameterIndex();
     m_FileData = std::make_unique<char[]>(size_t(fileStat.st_size) + 1);
     m_Index = m_FileData.get();
     m_Size = size_t(fileStat.st_size);
@@ -463,6 +468,29 @@ bool DataFile::FindParameter(const char * const param,
     char *p;
     size_t len = strlen(param);
 
+    if (searchFromStart && m_ParameterIndexValid && len)
+    {
+        // the index only holds whitespace delimited tokens so a parameter containing whitespace has to be scanned for
+        const char *c = param;
+        while (*c >= 33) c++;
+        if (*c == 0)
+        {
+            auto it = m_ParameterIndex.find(std::string_view(param, len));
+            if (it != m_ParameterIndex.end())
+            {
+                m_Index = m_FileData.get() + it->second + len;
+                return false;
+            }
+            if (m_ExitOnErrorFlag)
+            {
+                std::cerr << "Error: DataFile::FindParameter(" << param
+                << " - could not find parameter\n";
+                exit(1);
+            }
+            return true;
+        }
+    }
+
     if (searchFromStart) p = m_FileData.get();
     else p = m_Index;
 
@@ -500,6 +528,33 @@ bool DataFile::FindParameter(const char * const param,
     return true;
 }
 
+// one pass over the data recording where each whitespace delimited token first appears
+// the tokens are split in the same way that FindParameter tests for whitespace (< 33)
+// and like strstr the pass stops at the first zero
+void DataFile::BuildParameterIndex()
+{
+    m_ParameterIndex.clear();
+    m_ParameterIndexValid = false;
+    if (!m_FileData) return;
+    const char *start = m_FileData.get();
+    const char *p = start;
+    while (*p)
+    {
+        if (*p < 33) { p++; continue; }
+        const char *tokenStart = p;
+        while (*p >= 33) p++;
+        m_ParameterIndex.emplace(std::string_view(tokenStart, size_t(p - tokenStart)), size_t(tokenStart - start)); // does nothing if the token is already there
+    }
+    m_ParameterIndexValid = true;
+}
+
+void DataFile::InvalidateParameterIndex()
+{
+    if (!m_ParameterIndexValid) return;
+    m_ParameterIndex.clear();
+    m_ParameterIndexValid = false;
+}
+
 // read the next whitespace delimited token - up to (size - 1) characters
 // automatically copes with quote delimited strings
 bool DataFile::ReadNext(char *val, size_t size)
@@ -1402,6 +1457,7 @@ bool DataFile::WriteNext(bool val, char after)
 // note string must be shorter than kStorageIncrement
 bool DataFile::WriteNext(const char * const val, char after)
 {
+    InvalidateParameterIndex();
     const char *cp;
     bool needQuotes = false;
     size_t size = 0;
@@ -1452,6 +1508,7 @@ bool DataFile::WriteNext(const char * const val, char after)
 // note string must be shorter than kStorageIncrement
 bool DataFile::WriteNextQuotedString(const char * const val, char after)
 {
+    InvalidateParameterIndex();
     const char *cp;
     size_t size = 0;
 
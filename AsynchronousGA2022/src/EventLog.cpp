@@ -0,0 +1,103 @@
+/*
+ *  EventLog.cpp
+ *  AsynchronousGA
+ *
+ *  Created by Bill Sellers on 19/10/2026.
+ *  Copyright 2026 Bill Sellers. All rights reserved.
+ *
+ */
+
+#include "EventLog.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cinttypes>
+
+static const char kEventLogHeader[] = "AsynchronousGA2022 event log 1";
+
+EventLog::EventLog()
+{
+}
+
+int EventLog::OpenForWriting(const std::string &filename, uint64_t randomSeed)
+{
+    Close();
+    m_outputFile.open(filename, std::ios::out | std::ios::trunc);
+    if (!m_outputFile.is_open()) return __LINE__;
+    m_randomSeed = randomSeed;
+    m_outputFile << kEventLogHeader << "\n";
+    m_outputFile << "randomSeed " << randomSeed << "\n";
+    if (m_outputFile.fail()) return __LINE__;
+    m_writing = true;
+    return 0;
+}
+
+int EventLog::OpenForReading(const std::string &filename)
+{
+    Close();
+    m_inputFile.open(filename);
+    if (!m_inputFile.is_open()) return __LINE__;
+    if (!std::getline(m_inputFile, m_line) || m_line.compare(0, sizeof(kEventLogHeader) - 1, kEventLogHeader) != 0) return __LINE__;
+    if (!std::getline(m_inputFile, m_line) || std::sscanf(m_line.c_str(), "randomSeed %" SCNu64, &m_randomSeed) != 1) return __LINE__;
+    m_lineNumber = 2;
+    m_reading = true;
+    return 0;
+}
+
+void EventLog::Close()
+{
+    if (m_outputFile.is_open()) m_outputFile.close();
+    if (m_inputFile.is_open()) m_inputFile.close();
+    m_writing = false;
+    m_reading = false;
+    m_lineNumber = 0;
+}
+
+void EventLog::WriteRequest(size_t queueSize, bool sent)
+{
+    if (!m_writing) return;
+    m_outputFile << "request " << queueSize << " " << (sent ? 1 : 0) << "\n";
+}
+
+// %.17g so that the score reads back as exactly the same double
+void EventLog::WriteScore(uint32_t runID, double score)
+{
+    if (!m_writing) return;
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.17g", score);
+    m_outputFile << "score " << runID << " " << buffer << "\n";
+}
+
+// returns false at the end of the log or on a line that cannot be read
+bool EventLog::ReadNext(Event *event)
+{
+    if (!m_reading) return false;
+    while (std::getline(m_inputFile, m_line))
+    {
+        m_lineNumber++;
+        if (m_line.empty()) continue;
+        const char *ptr = m_line.c_str();
+        char *end;
+        if (std::strncmp(ptr, "request ", 8) == 0)
+        {
+            event->type = Request;
+            event->queueSize = size_t(std::strtoull(ptr + 8, &end, 10));
+            event->sent = std::strtol(end, &end, 10) != 0;
+            event->runID = 0;
+            event->score = 0;
+            return true;
+        }
+        if (std::strncmp(ptr, "score ", 6) == 0)
+        {
+            event->type = Score;
+            event->runID = uint32_t(std::strtoul(ptr + 6, &end, 10));
+            event->score = std::strtod(end, &end);
+            event->queueSize = 0;
+            event->sent = false;
+            return true;
+        }
+        return false;
+    }
+    return false;
+}
@@ -0,0 +1,63 @@
+/*
+ *  EventLog.h
+ *  AsynchronousGA
+ *
+ *  Created by Bill Sellers on 19/10/2026.
+ *  Copyright 2026 Bill Sellers. All rights reserved.
+ *
+ */
+
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include <cstddef>
+
+// Records the order that genome requests and scores were handled by the evolution loop
+// together with the random seed. Given the same parameters, starting population and
+// base XML file, replaying the log reproduces the run exactly without any clients.
+// The file is plain text with one event per line:
+//     request <queue size> <sent>
+//     score <run ID> <score>
+class EventLog
+{
+public:
+    enum EventType { Request, Score };
+
+    struct Event
+    {
+        EventType type = Request;
+        size_t queueSize = 0; // number of genome requests waiting which sets the offspring batch size
+        bool sent = false; // false if the client went away before the genome was sent
+        uint32_t runID = 0;
+        double score = 0;
+    };
+
+    EventLog();
+
+    int OpenForWriting(const std::string &filename, uint64_t randomSeed);
+    int OpenForReading(const std::string &filename);
+    void Close();
+
+    void WriteRequest(size_t queueSize, bool sent);
+    void WriteScore(uint32_t runID, double score);
+    bool ReadNext(Event *event);
+
+    bool IsWriting() const { return m_writing; }
+    bool IsReading() const { return m_reading; }
+    uint64_t GetRandomSeed() const { return m_randomSeed; }
+    size_t GetLineNumber() const { return m_lineNumber; }
+
+private:
+    std::ofstream m_outputFile;
+    std::ifstream m_inputFile;
+    std::string m_line;
+    bool m_writing = false;
+    bool m_reading = false;
+    uint64_t m_randomSeed = 0;
+    size_t m_lineNumber = 0;
+};
+
+#endif // EVENTLOG_H
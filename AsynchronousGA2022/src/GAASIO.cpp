@@ -11,12 +11,15 @@
 #include "Genome.h"
 #include "Population.h"
 #include "Mating.h"
+#include "OffspringBatch.h"
+#include "OffspringValidator.h"
 #include "Random.h"
 #include "Statistics.h"
 #include "GAASIO.h"
 #include "XMLConverter.h"
 #include "MD5.h"
 #include "ServerASIO.h"
+#include "RelayASIO.h"
 #include "ArgParse.h"
 
 #include "pystring.h"
@@ -37,11 +40,20 @@
 #include <algorithm>
 #include <cstdarg>
 #include <thread>
+#include <random>
 #include <cinttypes>
 #include <filesystem>
 #include <regex>
+#include <atomic>
+#include <condition_variable>
 #if ! ( defined(WIN32) || defined(_WIN32))
 #include <sys/resource.h>
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#include <io.h>
+#include <fcntl.h>
+#include <sys/types.h>
 #endif
 
 using namespace std::string_literals;
@@ -61,14 +73,23 @@ int main(int argc, const char **argv)
     std::string compileTime(__TIME__);
     ArgParse argparse;
     argparse.Initialise(argc, argv, "AsynchronousGA2022 distributed genetic algorithm program "s + compileDate + " "s + compileTime, 0, 0);
-    // required arguments
-    argparse.AddArgument("-p"s, "--parameterFile"s, "Parameter file specifying the GA options"s, ""s, 1, true, ArgParse::String);
-    argparse.AddArgument("-b"s, "--baseXMLFile"s, "Base XML file that is optimised"s, ""s, 1, true, ArgParse::String);
-    argparse.AddArgument("-s"s, "--startingPopulation"s, "Starting population"s, ""s, 1, true, ArgParse::String);
-    argparse.AddArgument("-t"s, "--serverPort"s, "The server TCP port to listen on"s, ""s, 1, true, ArgParse::Int);
+    // required arguments (except when running as a relay or applying a population)
+    argparse.AddArgument("-p"s, "--parameterFile"s, "Parameter file specifying the GA options"s, ""s, 1, false, ArgParse::String);
+    argparse.AddArgument("-b"s, "--baseXMLFile"s, "Base XML file that is optimised"s, ""s, 1, false, ArgParse::String);
+    argparse.AddArgument("-s"s, "--startingPopulation"s, "Starting population"s, ""s, 1, false, ArgParse::String);
+    argparse.AddArgument("-t"s, "--serverPort"s, "The server TCP port to listen on"s, "0"s, 1, false, ArgParse::Int);
     // optional arguments
     argparse.AddArgument("-o"s, "--outputDirectory"s, "Output directory [uses current date & time]"s, ""s, 1, false, ArgParse::String);
     argparse.AddArgument("-l"s, "--logLevel"s, "0, 1, 2 outputs more detail with higher numbers [0]"s, "0"s, 1, false, ArgParse::Int);
+    argparse.AddArgument("-r"s, "--relay"s, "Run as a relay for local clients forwarding to the master at host:port"s, ""s, 1, false, ArgParse::String);
+    argparse.AddArgument("-c"s, "--relayConnections"s, "Number of relay connections to the master [4]"s, "4"s, 1, false, ArgParse::Int);
+    argparse.AddArgument("-e"s, "--seed"s, "Random number seed [chosen at random and written to the log]"s, ""s, 1, false, ArgParse::String);
+    argparse.AddArgument("-g"s, "--eventLog"s, "Record the order of genome requests and scores to this file for --replay"s, ""s, 1, false, ArgParse::String);
+    argparse.AddArgument("-y"s, "--replay"s, "Rerun the evolution from an event log without a server or any clients"s, ""s, 1, false, ArgParse::String);
+    argparse.AddArgument("-a"s, "--applyPopulation"s, "Write the base XML for each genome in this population file to --outputDirectory or --applyOutput and exit"s, ""s, 1, false, ArgParse::String);
+    argparse.AddArgument("-n"s, "--applyCount"s, "Number of genomes to write with --applyPopulation starting with the fittest [all]"s, "0"s, 1, false, ArgParse::Int);
+    argparse.AddArgument("-k"s, "--applyOutput"s, "Write all the XML from --applyPopulation to this one file (or to stdout)"s, ""s, 1, false, ArgParse::String);
+    argparse.AddArgument("-j"s, "--threads"s, "Number of threads used by --applyPopulation [number of cores]"s, "0"s, 1, false, ArgParse::Int);
 
     int err = argparse.Parse();
     if (err)
@@ -77,16 +98,73 @@ int main(int argc, const char **argv)
         exit(1);
     }
 
-    int logLevel, serverPort;
-    std::string baseXMLFile, parameterFile, outputDirectory, startingPopulation;
+    int logLevel, serverPort, relayConnections, applyCount, threads;
+    std::string baseXMLFile, parameterFile, outputDirectory, startingPopulation, relay, seed, eventLog, replay, applyPopulation, applyOutput;
     argparse.Get("--logLevel"s, &logLevel);
     argparse.Get("--serverPort"s, &serverPort);
     argparse.Get("--baseXMLFile"s, &baseXMLFile);
     argparse.Get("--parameterFile"s, &parameterFile);
     argparse.Get("--outputDirectory"s, &outputDirectory);
     argparse.Get("--startingPopulation"s, &startingPopulation);
+    argparse.Get("--relay"s, &relay);
+    argparse.Get("--relayConnections"s, &relayConnections);
+    argparse.Get("--seed"s, &seed);
+    argparse.Get("--eventLog"s, &eventLog);
+    argparse.Get("--replay"s, &replay);
+    argparse.Get("--applyPopulation"s, &applyPopulation);
+    argparse.Get("--applyCount"s, &applyCount);
+    argparse.Get("--applyOutput"s, &applyOutput);
+    argparse.Get("--threads"s, &threads);
+
+    if (applyPopulation.size())
+    {
+        if (baseXMLFile.empty() || (outputDirectory.empty() && applyOutput.empty()))
+        {
+            std::cerr << "Error: --applyPopulation needs --baseXMLFile and either --outputDirectory or --applyOutput\n\n";
+            argparse.Usage();
+            exit(1);
+        }
+        return GAMain::ApplyPopulation(applyPopulation, baseXMLFile, outputDirectory, applyOutput, size_t(std::max(applyCount, 0)), size_t(std::max(threads, 0)));
+    }
+
+    // a replay has no server so it does not need a port but a relay always does
+    if (serverPort <= 0 && (replay.empty() || relay.size()))
+    {
+        std::cerr << "Error: --serverPort is required unless --applyPopulation or --replay is used\n\n";
+        argparse.Usage();
+        exit(1);
+    }
+
+    if (relay.size())
+    {
+        RelayASIO relayASIO;
+        relayASIO.SetLogLevel(logLevel);
+        relayASIO.SetServerPort(serverPort);
+        return relayASIO.Process(relay, relayConnections);
+    }
+
+    if (parameterFile.empty() || baseXMLFile.empty() || startingPopulation.empty())
+    {
+        std::cerr << "Error: --parameterFile, --baseXMLFile and --startingPopulation are required unless --relay is used\n\n";
+        argparse.Usage();
+        exit(1);
+    }
     
     GAMain ga;
+    if (seed.size())
+    {
+        char *end;
+        uint64_t randomSeed = std::strtoull(seed.c_str(), &end, 10);
+        if (*end || seed[0] == '-')
+        {
+            std::cerr << "Error: --seed must be an unsigned integer\n\n";
+            argparse.Usage();
+            exit(1);
+        }
+        ga.SetRandomSeed(randomSeed);
+    }
+    ga.SetEventLogFile(eventLog);
+    ga.SetReplayFile(replay);
     ga.SetLogLevel(logLevel);
     ga.LoadBaseXMLFile(baseXMLFile);
     ga.SetServerPort(serverPort);
@@ -148,6 +226,28 @@ int GAMain::Process(const std::string &parameterFile, const std::string &outputD
         return (__LINE__);
     }
     ReportProgress(m_parameterFile + " read"s, 0);
+    m_random.SetGeneratorType(m_preferences.randomNumberGenerator);
+
+    // the seed is always set explicitly so that it can be logged and the run repeated
+    if (m_replayFile.size())
+    {
+        m_replayFile = pystring::os::path::abspath(m_replayFile, std::filesystem::current_path().u8string());
+        if (m_replayLog.OpenForReading(m_replayFile))
+        {
+            ReportProgress("Error reading event log "s + m_replayFile, 0);
+            return __LINE__;
+        }
+        if (m_randomSeedSet && m_randomSeed != m_replayLog.GetRandomSeed())
+            ReportProgress(ToString("Info: Using random seed %" PRIu64 " from the event log", m_replayLog.GetRandomSeed()), 0);
+        SetRandomSeed(m_replayLog.GetRandomSeed());
+        ReportProgress(m_replayFile + " replaying"s, 0);
+    }
+    if (!m_randomSeedSet)
+    {
+        std::random_device randomDevice;
+        SetRandomSeed((uint64_t(randomDevice()) << 32) ^ uint64_t(randomDevice()));
+    }
+    m_random.RandomSeed(m_randomSeed);
 
     // sanity check some of the parameters
     if (m_preferences.parentsToKeep >= m_preferences.populationSize)
@@ -216,10 +316,23 @@ int GAMain::Process(const std::string &parameterFile, const std::string &outputD
     m_outputLogFile << "GA build " << __DATE__ << " " << __TIME__ "\n";
     m_outputLogFile << "Log produced " << asctime(theLocalTime);
     m_outputLogFile << "parameterFile \"" << m_parameterFile << "\"\n";
+    m_outputLogFile << "randomSeed " << m_randomSeed << "\n";
+    if (m_replayFile.size()) m_outputLogFile << "replay \"" << m_replayFile << "\"\n";
     m_outputLogFile << m_preferences.GetPreferencesString() << "\n";
     m_outputLogFile.flush();
     ReportProgress(logFileName + " opened"s, 0);
 
+    if (m_eventLogFile.size())
+    {
+        m_eventLogFile = pystring::os::path::abspath(m_eventLogFile, std::filesystem::current_path().u8string());
+        if (m_eventLog.OpenForWriting(m_eventLogFile, m_randomSeed))
+        {
+            ReportProgress(ToString("Error opening \"%s\": %s", m_eventLogFile.c_str(), std::strerror(errno)), 0);
+            return __LINE__;
+        }
+        ReportProgress(m_eventLogFile + " opened"s, 0);
+    }
+
     // initialise the population
     m_startPopulation.SetGlobalCircularMutation(m_preferences.circularMutation);
     m_startPopulation.SetResizeControl(m_preferences.resizeControl);
@@ -238,7 +351,7 @@ int GAMain::Process(const std::string &parameterFile, const std::string &outputD
         ReportProgress("Info: Starting population size "s + std::to_string(m_startPopulation.GetPopulationSize()) + " does not match specified population size "s + std::to_string(m_preferences.populationSize) + " - using standard fixup"s, 0);
         m_startPopulation.ResizePopulation(m_preferences.populationSize, &m_random);
     }
-    if (m_startPopulation.GetGenome(0)->GetGenomeLength() != m_preferences.genomeLength)
+    if (m_startPopulation.GetGenomeLength() != m_preferences.genomeLength)
     {
         ReportProgress("Error: Starting population genome does not match specified genome length"s, 0);
         return __LINE__;
@@ -253,7 +366,10 @@ int GAMain::Process(const std::string &parameterFile, const std::string &outputD
     m_evolvePopulation.SetSelectionType(m_preferences.parentSelection);
     m_evolvePopulation.SetParentsToKeep(m_preferences.parentsToKeep);
 
-    if (Evolve())
+    int err = Evolve();
+    m_eventLog.Close();
+    m_replayLog.Close();
+    if (err)
     {
         ReportProgress("Error: Terminated due to Evolve failure"s, 0);
         return __LINE__;
@@ -283,36 +399,76 @@ int GAMain::Evolve()
     uint32_t submitCount = 0;
     uint32_t returnCount = 0;
     int startPopulationIndex = 0;
-    size_t parent1Rank, parent2Rank;
-    int mutationCount;
-    Genome *parent1;
-    Genome *parent2;
     TenPercentiles tenPercentiles;
+    Statistics statistics;
     double maxFitness = -DBL_MAX;
     double lastMaxFitness = -DBL_MAX;
     std::string filename;
     bool stopSendingFlag = false;
-    std::map<uint32_t, std::unique_ptr<RunSpecifier>> runningList;
+    std::map<uint32_t, RunSpecifier> runningList;
+    // the evaluation loop recycles the map nodes, the gene storage and the message buffers so once it is
+    // running it does not allocate for each genome (make allocation_check tests this)
+    // but the network layer still allocates the decoded request and score and the encoded genome it sends
+    std::vector<std::map<uint32_t, RunSpecifier>::node_type> spareRunningListNodes;
+    MessageASIO requestMessage;
+    MessageASIO scoreMessage;
+    Genome offspring;
+    std::vector<char> dataMessage;
     Mating mating(&m_random);
+    Mating::OffspringSettings offspringSettings;
+    offspringSettings.crossoverChance = m_preferences.crossoverChance;
+    offspringSettings.crossoverType = m_preferences.crossoverType;
+    offspringSettings.gaussianMutationChance = m_preferences.gaussianMutationChance;
+    offspringSettings.multipleGaussian = m_preferences.multipleGaussian;
+    offspringSettings.geometricSkipMutation = m_preferences.geometricSkipMutation;
+    offspringSettings.bounceMutation = m_preferences.bounceMutation;
+    offspringSettings.frameShiftMutationChance = m_preferences.frameShiftMutationChance;
+    offspringSettings.duplicationMutationChance = m_preferences.duplicationMutationChance;
+    offspringSettings.clampShiftedGenes = m_preferences.clampShiftedGenes;
+    OffspringBatch offspringBatch;
+    const size_t maxOffspringBatchSize = 64;
     bool shouldStop = false;
+    // when replaying the events come from the log rather than the queues and nothing is sent
+    bool replaying = m_replayLog.IsReading();
+    EventLog::Event replayEvent;
+    // offspring can be checked against the base XML before they are sent
+    OffspringValidator offspringValidator;
+    bool validating = m_preferences.validateOffspring;
+    std::vector<char> validOffspring;
+    uint64_t consecutiveRejections = 0;
+    uint64_t totalRejections = 0;
+    if (validating && offspringValidator.Initialise(m_baseXMLFile.GetRawData(), m_baseXMLFile.GetSize()))
+    {
+        ReportProgress("Error reading the base XML file for the offspring validator so offspring will not be validated"s, 0);
+        validating = false;
+    }
 
     ReportInfo(ToString("Evolve Identifier = %" PRIu64, m_evolveIdentifier));
 
     // start the TCP server
-    ServerASIO *server = new ServerASIO();
-    if (server->setPort(uint16_t(m_tcpPort)))
+    ServerASIO *server = nullptr;
+    std::thread *serverThread = nullptr;
+    if (!replaying)
     {
-        ReportProgress(ToString("Unable to set listening port to %d", m_tcpPort), 0);
-        delete server;
-        return __LINE__;
+        server = new ServerASIO();
+        if (server->setPort(uint16_t(m_tcpPort)))
+        {
+            ReportProgress(ToString("Unable to set listening port to %d", m_tcpPort), 0);
+            delete server;
+            return __LINE__;
+        }
+        server->attach("req_gen_"s, std::bind(&GAMain::handleRequestGenome, this, std::placeholders::_1));
+        server->attach("relaygen"s, std::bind(&GAMain::handleRelayRequestGenome, this, std::placeholders::_1));
+        server->attach("req_xml_"s, std::bind(&GAMain::handleRequestXML, this, std::placeholders::_1));
+        server->attach("score___"s, std::bind(&GAMain::handleScore, this, std::placeholders::_1));
+        serverThread = new std::thread(&ServerASIO::start, server);
     }
-    server->attach("req_gen_"s, std::bind(&GAMain::handleRequestGenome, this, std::placeholders::_1));
-    server->attach("req_xml_"s, std::bind(&GAMain::handleRequestXML, this, std::placeholders::_1));
-    server->attach("score___"s, std::bind(&GAMain::handleScore, this, std::placeholders::_1));
-    std::thread *serverThread = new std::thread(&ServerASIO::start, server);
     StopServerASIOGuard serverGuard(server, serverThread);
-    m_requestGenomeQueueEnabled = true;
-    server->getLocalAddress(&m_ipAddress, &m_port);
+    if (server)
+    {
+        m_requestGenomeQueueEnabled = true;
+        server->getLocalAddress(&m_ipAddress, &m_port);
+    }
 
     int progressValue = 0;
     int lastProgressValue = -1;
@@ -349,12 +505,12 @@ int GAMain::Evolve()
                 ReportInfo(ToString("Progress = %d", progressValue));
             }
         }
-        if (currentTime >= lastSlowTime + slowPeriodicTaskInterval) // this part of the loop is for things that don't need to be done all that often
+        if (currentTime >= lastSlowTime + slowPeriodicTaskInterval && !replaying) // this part of the loop is for things that don't need to be done all that often
         {
             lastSlowTime = currentTime;
             for (auto &&it = runningList.begin(); it != runningList.end();)
             {
-                if (currentTime - it->second->startTime > m_preferences.watchDogTimerLimit)
+                if (currentTime - it->second.startTime > m_preferences.watchDogTimerLimit)
                 {
                     ReportProgress(ToString("RunID %" PRIu32 " has been deleted", it->first), 2);
                     it = runningList.erase(it); // erase invalidates the iterator but returns the next valid iterator
@@ -363,68 +519,104 @@ int GAMain::Evolve()
             }
         }
 
-        size_t genomeQueueSize = GenomeRequestQueueSize();
+        size_t genomeQueueSize;
+        if (replaying)
+        {
+            if (!m_replayLog.ReadNext(&replayEvent))
+            {
+                ReportProgress(ToString("Replay ended at line %zu of the event log", m_replayLog.GetLineNumber()), 0);
+                break;
+            }
+            genomeQueueSize = replayEvent.type == EventLog::Request ? replayEvent.queueSize : 0;
+        }
+        else
+        {
+            genomeQueueSize = GenomeRequestQueueSize();
+        }
         if (genomeQueueSize)
         {
-            MessageASIO message;
-            GetNextGenomeRequest(&message);
-            const RequestMessage *messageContent = reinterpret_cast<const RequestMessage *>(message.content.data());
-            Genome offspring;
+            if (replaying) requestMessage.content.assign(sizeof(RequestMessage), 0);
+            else GetNextGenomeRequest(&requestMessage);
+            const RequestMessage *messageContent = reinterpret_cast<const RequestMessage *>(requestMessage.content.data());
             // if we are still working from the start population, just get the next one
             if (startPopulationIndex < m_startPopulation.GetPopulationSize())
             {
-                offspring = *m_startPopulation.GetGenome(startPopulationIndex);
+                m_startPopulation.GetGenome(startPopulationIndex, &offspring);
                 startPopulationIndex++;
             }
             else
             {
                 // create a new offspring
-                mutationCount = 0;
-                while (mutationCount == 0) // this means we always get some mutation (no point in getting unmutated offspring)
+                // all the queued requests are bred together because the population cannot change until they have been sent
+                // and if the whole batch fails validation another one is bred
+                while (offspringBatch.GetRemaining() == 0)
                 {
-                    if (m_evolvePopulation.GetPopulationSize()) parent1 = m_evolvePopulation.ChooseParent(&parent1Rank, &m_random);
-                    else parent1 = m_startPopulation.ChooseParent(&parent1Rank, &m_random);
-                    if (m_random.CoinFlip(m_preferences.crossoverChance))
-                    {
-                        if (m_evolvePopulation.GetPopulationSize()) parent2 = m_evolvePopulation.ChooseParent(&parent2Rank, &m_random);
-                        else parent2 = m_startPopulation.ChooseParent(&parent2Rank, &m_random);
-                        offspring = *parent1;
-                        mutationCount += mating.Mate(parent1, parent2, &offspring, m_preferences.crossoverType);
-                    }
-                    else
+                    Population *parentPopulation = m_evolvePopulation.GetPopulationSize() ? &m_evolvePopulation : &m_startPopulation;
+                    mating.BreedBatch(parentPopulation, offspringSettings, std::min(genomeQueueSize, maxOffspringBatchSize), &offspringBatch);
+                    if (!validating) break;
+                    offspringValidator.Validate(offspringBatch, &validOffspring);
+                    for (size_t i = 0; i < validOffspring.size(); i++)
                     {
-                        offspring = *parent1;
+                        if (validOffspring[i])
+                        {
+                            consecutiveRejections = 0;
+                            continue;
+                        }
+                        offspringBatch.Reject(i);
+                        totalRejections++;
+                        ReportProgress(ToString("Offspring rejected because the base XML does not evaluate to finite numbers (%" PRIu64 " so far)", totalRejections), 2);
+                        if (++consecutiveRejections > uint64_t(m_preferences.maxOffspringRejections))
+                        {
+                            // the rest of this batch is left unchecked like every batch from now on
+                            ReportProgress(ToString("%" PRIu64 " offspring in a row have failed validation so validation has been switched off", consecutiveRejections), 0);
+                            validating = false;
+                            break;
+                        }
                     }
-                    if (m_preferences.multipleGaussian)  mutationCount += mating.MultipleGaussianMutate(&offspring, m_preferences.gaussianMutationChance, m_preferences.bounceMutation);
-                    else mutationCount += mating.GaussianMutate(&offspring, m_preferences.gaussianMutationChance, m_preferences.bounceMutation);
-
-                    mutationCount += mating.FrameShiftMutate(&offspring, m_preferences.frameShiftMutationChance);
-                    mutationCount += mating.DuplicationMutate(&offspring, m_preferences.duplicationMutationChance);
                 }
+                offspringBatch.TakeNext(&offspring);
             }
             // got a genome to send
-            std::vector<char> dataMessage(sizeof(DataMessage) + offspring.GetGenomeLength() * sizeof(double));
+            dataMessage.assign(sizeof(DataMessage) + offspring.GetGenomeLength() * sizeof(double), 0);
             DataMessage *dataMessagePtr = reinterpret_cast<DataMessage *>(dataMessage.data());
             strncpy(dataMessagePtr->text, "genome", sizeof(dataMessagePtr->text));
 //            server.GetMyAddress(&dataMessagePtr->senderIP, &dataMessagePtr->senderPort);
             dataMessagePtr->evolveIdentifier = m_evolveIdentifier;
+            if (requestMessage.content.compare(0, 8, "relaygen"s) == 0) dataMessagePtr->senderPort = messageContent->senderPort; // the relay uses this to route the genome to its client
             dataMessagePtr->runID = submitCount;
             dataMessagePtr->genomeLength = uint32_t(offspring.GetGenomeLength());
             dataMessagePtr->xmlLength = uint32_t(m_baseXMLFile.GetSize());
             std::copy(std::begin(m_md5), std::end(m_md5), std::begin(dataMessagePtr->md5));
             std::copy_n(offspring.GetGenes()->data(), offspring.GetGenomeLength(), dataMessagePtr->payload.genome);
-            auto sharedPtr = message.session.lock();
-            if (sharedPtr)
+            auto sharedPtr = requestMessage.session.lock();
+            bool sent = sharedPtr || (replaying && replayEvent.sent); // a replay has no session but sends what the recording sent
+            m_eventLog.WriteRequest(genomeQueueSize, sent);
+            if (sent)
             {
-                sharedPtr->write(dataMessage.data(), dataMessage.size());
-                std::unique_ptr<RunSpecifier> runSpecifier = std::make_unique<RunSpecifier>();
-                runSpecifier->genome = std::move(offspring);
+                if (sharedPtr) sharedPtr->write(dataMessage.data(), dataMessage.size());
+                std::map<uint32_t, RunSpecifier>::node_type node;
+                RunSpecifier *runSpecifier;
+                if (spareRunningListNodes.size())
+                {
+                    node = std::move(spareRunningListNodes.back());
+                    spareRunningListNodes.pop_back();
+                    node.key() = submitCount;
+                    runSpecifier = &node.mapped();
+                }
+                else
+                {
+                    runSpecifier = &runningList[submitCount];
+                }
+                std::swap(runSpecifier->genome, offspring); // offspring picks up the gene storage left in a recycled node
                 runSpecifier->startTime = currentTime;
                 runSpecifier->senderPort = messageContent->senderPort;
                 runSpecifier->senderIP = messageContent->senderIP;
-                runningList[submitCount] = std::move(runSpecifier);
-                std::string address = ConvertAddressPortToString(messageContent->senderIP, uint16_t(messageContent->senderPort));
-                ReportProgress(ToString("Sample %" PRIu32 " [%zu bytes] sent to %s evolveIdentifier %" PRIu64, submitCount, dataMessage.size(), address.c_str(), m_evolveIdentifier), 2);
+                if (node) runningList.insert(std::move(node));
+                if (m_logLevel >= 2)
+                {
+                    std::string address = ConvertAddressPortToString(messageContent->senderIP, uint16_t(messageContent->senderPort));
+                    ReportProgress(ToString("Sample %" PRIu32 " [%zu bytes] sent to %s evolveIdentifier %" PRIu64, submitCount, dataMessage.size(), address.c_str(), m_evolveIdentifier), 2);
+                }
                 submitCount++;
             }
             else
@@ -434,41 +626,64 @@ int GAMain::Evolve()
             continue;
         }
 
-        size_t scoreQueueSize = ScoreQueueSize();
+        size_t scoreQueueSize = replaying ? 1 : ScoreQueueSize();
         if (scoreQueueSize)
         {
-            MessageASIO message;
-            GetNextScore(&message);
-            const RequestMessage *messageContent = reinterpret_cast<const RequestMessage *>(message.content.data());
+            if (replaying)
+            {
+                RequestMessage replayScore = {};
+                replayScore.evolveIdentifier = m_evolveIdentifier;
+                replayScore.runID = replayEvent.runID;
+                replayScore.score = replayEvent.score;
+                scoreMessage.content.assign(reinterpret_cast<const char *>(&replayScore), sizeof(RequestMessage));
+            }
+            else
+            {
+                GetNextScore(&scoreMessage);
+            }
+            const RequestMessage *messageContent = reinterpret_cast<const RequestMessage *>(scoreMessage.content.data());
             if (returnCount % 100 == 0) ReportInfo(ToString("Return Count = %" PRIu32, returnCount));
             uint32_t index = messageContent->runID;
             double result = messageContent->score;
-            std::string address = ConvertAddressPortToString(messageContent->senderIP, messageContent->senderPort);
-            ReportProgress(ToString("Sample %" PRIu32 " score %g from %s evolveIdentifier %" PRIu64, index, result, address.c_str(), messageContent->evolveIdentifier), 2);
+            if (m_logLevel >= 2)
+            {
+                std::string address = ConvertAddressPortToString(messageContent->senderIP, messageContent->senderPort);
+                ReportProgress(ToString("Sample %" PRIu32 " score %g from %s evolveIdentifier %" PRIu64, index, result, address.c_str(), messageContent->evolveIdentifier), 2);
+            }
             auto iter = runningList.find(index);
             if (messageContent->evolveIdentifier != m_evolveIdentifier || iter == runningList.end())
             {
+                std::string address = ConvertAddressPortToString(messageContent->senderIP, messageContent->senderPort);
                 ReportProgress(ToString("Sample %" PRIu32 " not found score %g from %s evolveIdentifier %" PRIu64, index, result, address.c_str(), messageContent->evolveIdentifier), 1);
                 continue;
             }
-            iter->second->genome.SetFitness(result);
-            // std::cerr << iter->second->genome;
-            m_evolvePopulation.InsertGenome(std::move(iter->second->genome), m_preferences.populationSize);
-            runningList.erase(iter);
+            m_eventLog.WriteScore(index, result);
+            iter->second.genome.SetFitness(result);
+            // std::cerr << iter->second.genome;
+            m_evolvePopulation.InsertGenome(iter->second.genome, m_preferences.populationSize);
+            offspringBatch.Clear(); // any offspring left over were bred from the old population
+            spareRunningListNodes.push_back(runningList.extract(iter)); // keep the node and its gene storage for the next genome that is sent
 
             if (returnCount % uint32_t(m_preferences.outputStatsEvery) == uint32_t(m_preferences.outputStatsEvery) - 1)
             {
                 CalculateTenPercentiles(&m_evolvePopulation, &tenPercentiles);
                 m_outputLogFile << std::setw(10) << returnCount << " ";
-                m_outputLogFile << tenPercentiles << "\n";
+                m_outputLogFile << tenPercentiles;
+                if (m_preferences.outputStatistics)
+                {
+                    // the population keeps these up to date so they are cheap enough to output on every return
+                    CalculateStatistics(&m_evolvePopulation, &statistics);
+                    m_outputLogFile << " " << statistics;
+                }
+                m_outputLogFile << "\n";
                 m_outputLogFile.flush();
             }
 
             if (returnCount % uint32_t(m_preferences.saveBestEvery) == uint32_t(m_preferences.saveBestEvery) - 1 || returnCount == 1)
             {
-                if (m_evolvePopulation.GetLastGenome()->GetFitness() > maxFitness)
+                if (m_evolvePopulation.GetLastFitness() > maxFitness)
                 {
-                    maxFitness = m_evolvePopulation.GetLastGenome()->GetFitness();
+                    maxFitness = m_evolvePopulation.GetLastFitness();
                     filename = pystring::os::path::join(m_outputFolderName, ToString(m_bestGenomeModel.c_str(), returnCount));
                     try
                     {
@@ -476,7 +691,9 @@ int GAMain::Evolve()
                         std::ofstream bestFile;
                         bestFile.exceptions (std::ios::failbit|std::ios::badbit);
                         bestFile.open(filename);
-                        bestFile << *m_evolvePopulation.GetLastGenome();
+                        Genome bestGenome;
+                        m_evolvePopulation.GetLastGenome(&bestGenome);
+                        bestFile << bestGenome;
                         bestFile.close();
                     }
                     catch (std::exception& e)
@@ -515,11 +732,12 @@ int GAMain::Evolve()
     }
 
     if (returnCount) returnCount--; // reduce return count back to the value for the last actual return
+    if (m_preferences.validateOffspring) ReportProgress(ToString("%" PRIu64 " offspring failed validation", totalRejections), 1);
     ReportProgress(ToString("GA evolveIdentifier = %" PRIu64 " ended returnCount = %" PRIu32 "", m_evolveIdentifier, returnCount), 1);
 
     if (m_evolvePopulation.GetPopulationSize())
     {
-        if (m_evolvePopulation.GetLastGenome()->GetFitness() > maxFitness)
+        if (m_evolvePopulation.GetLastFitness() > maxFitness)
         {
             filename = pystring::os::path::join(m_outputFolderName, ToString(m_bestGenomeModel.c_str(), returnCount));
             if (!std::filesystem::exists(filename))
@@ -528,7 +746,9 @@ int GAMain::Evolve()
                 {
                     ReportProgress("Writing final "s + filename, 1);
                     std::ofstream bestFile(filename);
-                    bestFile << *m_evolvePopulation.GetLastGenome();
+                    Genome bestGenome;
+                    m_evolvePopulation.GetLastGenome(&bestGenome);
+                    bestFile << bestGenome;
                 }
                 catch (std::exception& e)
                 {
@@ -589,6 +809,136 @@ void GAMain::ApplyGenome(const std::string &inputGenome, const std::string &inpu
     outputXMLData.WriteFile(outputXML);
 }
 
+namespace
+{
+
+// returns -1 on error
+int OpenOutputFile(const std::string &filename)
+{
+#if defined(_WIN32) || defined(WIN32)
+    return _wopen(std::filesystem::u8path(filename).c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    return open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+}
+
+void CloseOutputFile(int fileDescriptor)
+{
+#if defined(_WIN32) || defined(WIN32)
+    _close(fileDescriptor);
+#else
+    close(fileDescriptor);
+#endif
+}
+
+}
+
+// writes the base XML for the count fittest genomes in the population (all of them if count is 0)
+// the template is read once and each thread has its own XMLConverter so the expressions are only compiled once per thread
+// with a directory the files are Genome_<rank>.xml with the fittest as rank 0
+// otherwise the XML is concatenated in rank order into outputFile (or to standard output if it is "stdout")
+int GAMain::ApplyPopulation(const std::string &inputPopulation, const std::string &inputXML, const std::string &outputDirectory, const std::string &outputFile, size_t count, size_t threadCount)
+{
+    Population population;
+    if (population.ReadPopulation(inputPopulation.c_str()))
+    {
+        std::cerr << "Error: could not read population " << inputPopulation << "\n";
+        return __LINE__;
+    }
+    DataFile baseXMLFile;
+    if (baseXMLFile.ReadFile(inputXML))
+    {
+        std::cerr << "Error: could not read base XML " << inputXML << "\n";
+        return __LINE__;
+    }
+    {
+        // every thread loads the same template so a bad one is reported once here before any output is started
+        XMLConverter xmlConverter;
+        if (xmlConverter.LoadBaseXMLString(baseXMLFile.GetRawData(), baseXMLFile.GetSize())) return __LINE__;
+    }
+
+    size_t populationSize = population.GetPopulationSize();
+    if (count == 0 || count > populationSize) count = populationSize;
+    int genomeSize = int(population.GetGenomeLength());
+    std::vector<const double *> genomes(count);
+    for (size_t i = 0; i < count; i++) genomes[i] = population.GetGenes(populationSize - 1 - i);
+
+    int outputFileDescriptor = -1;
+    bool closeOutput = false;
+    std::filesystem::path directory;
+    if (outputFile.size())
+    {
+        if (outputFile == "stdout"s) outputFileDescriptor = fileno(stdout);
+        else { outputFileDescriptor = OpenOutputFile(outputFile); closeOutput = true; }
+        if (outputFileDescriptor < 0)
+        {
+            std::cerr << "Error: could not open " << outputFile << "\n";
+            return __LINE__;
+        }
+    }
+    else
+    {
+        directory = std::filesystem::u8path(outputDirectory);
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        if (ec)
+        {
+            std::cerr << "Error: could not create " << outputDirectory << ": " << ec.message() << "\n";
+            return __LINE__;
+        }
+    }
+    int width = int(std::to_string(count > 0 ? count - 1 : 0).size());
+
+    // genomes are handed out in rank order and when writing a single stream each thread waits its turn
+    if (threadCount == 0) threadCount = std::max(size_t(1), size_t(std::thread::hardware_concurrency()));
+    threadCount = std::min(threadCount, std::max(count, size_t(1)));
+    std::atomic<size_t> nextGenome(0);
+    std::atomic<int> err(0);
+    size_t nextToWrite = 0;
+    std::mutex writeMutex;
+    std::condition_variable writeCondition;
+    auto worker = [&]()
+    {
+        XMLConverter xmlConverter;
+        xmlConverter.LoadBaseXMLString(baseXMLFile.GetRawData(), baseXMLFile.GetSize());
+        std::vector<double> genes(static_cast<size_t>(genomeSize));
+        for (size_t i = nextGenome++; i < count; i = nextGenome++)
+        {
+            std::copy(genomes[i], genomes[i] + genomeSize, genes.begin());
+            xmlConverter.ApplyGenome(genomeSize, genes.data());
+            if (outputFileDescriptor < 0)
+            {
+                std::string filename = ToString("Genome_%0*zu.xml", width, i);
+                std::string path = (directory / std::filesystem::u8path(filename)).u8string();
+                int fileDescriptor = OpenOutputFile(path);
+                if (fileDescriptor < 0 || xmlConverter.WriteFormattedXML(fileDescriptor))
+                {
+                    std::cerr << "Error: could not write " << path << "\n";
+                    err = __LINE__;
+                }
+                if (fileDescriptor >= 0) CloseOutputFile(fileDescriptor);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(writeMutex);
+            writeCondition.wait(lock, [&]() { return nextToWrite == i; });
+            if (err == 0 && xmlConverter.WriteFormattedXML(outputFileDescriptor))
+            {
+                std::cerr << "Error: could not write " << outputFile << "\n";
+                err = __LINE__;
+            }
+            nextToWrite++;
+            writeCondition.notify_all();
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threadCount; i++) threads.emplace_back(worker);
+    worker();
+    for (auto &&thread : threads) thread.join();
+
+    if (closeOutput) CloseOutputFile(outputFileDescriptor);
+    return err;
+}
+
 void GAMain::SetServerPort(int port)
 {
     m_tcpPort = port;
@@ -706,10 +1056,19 @@ void GAMain::handleRequestGenome(MessageASIO message)
                 if (sharedPtr1.get() == sharedPtr2.get()) return;
             }
         }
-        m_requestGenomeQueue.push_back(message);
+        m_requestGenomeQueue.push_back(std::move(message));
     }
 }
 
+// relays multiplex many clients over one session so every request is queued
+void GAMain::handleRelayRequestGenome(MessageASIO message)
+{
+    if (message.content.size() < sizeof(RequestMessage)) return;
+    if (!m_requestGenomeQueueEnabled) return;
+    std::unique_lock<std::mutex> lock(m_requestGenomeMutex);
+    m_requestGenomeQueue.push_back(std::move(message));
+}
+
 void GAMain::handleRequestXML(MessageASIO message)
 {
     if (message.content.size() < sizeof(RequestMessage)) return;
@@ -721,7 +1080,7 @@ void GAMain::handleRequestXML(MessageASIO message)
     dataMessagePtr->senderPort = m_port;
     dataMessagePtr->runID = std::numeric_limits<uint32_t>::max();
     dataMessagePtr->evolveIdentifier = m_evolveIdentifier;
-    dataMessagePtr->genomeLength = uint32_t(m_startPopulation.GetFirstGenome()->GetGenomeLength());
+    dataMessagePtr->genomeLength = uint32_t(m_startPopulation.GetGenomeLength());
     dataMessagePtr->xmlLength = uint32_t(m_baseXMLFile.GetSize());
     std::copy(std::begin(m_md5), std::end(m_md5), std::begin(dataMessagePtr->md5));
     std::copy_n(m_baseXMLFile.GetRawData(), m_baseXMLFile.GetSize(), dataMessagePtr->payload.xml);
@@ -784,7 +1143,7 @@ void GAMain::handleScore(MessageASIO message)
 {
     if (message.content.size() < sizeof(RequestMessage)) return;
     std::unique_lock<std::mutex> lock(m_scoreMutex);
-    m_scoreQueue.push_back(message);
+    m_scoreQueue.push_back(std::move(message));
 }
 
 size_t GAMain::GenomeRequestQueueSize()
@@ -802,14 +1161,14 @@ size_t GAMain::ScoreQueueSize()
 void GAMain::GetNextGenomeRequest(MessageASIO *message)
 {
     std::unique_lock<std::mutex> lock(m_requestGenomeMutex);
-    *message = m_requestGenomeQueue.front();
+    *message = std::move(m_requestGenomeQueue.front());
     m_requestGenomeQueue.pop_front();
 }
 
 void GAMain::GetNextScore(MessageASIO *message)
 {
     std::unique_lock<std::mutex> lock(m_scoreMutex);
-    *message = m_scoreQueue.front();
+    *message = std::move(m_scoreQueue.front());
     m_scoreQueue.pop_front();
 }
 
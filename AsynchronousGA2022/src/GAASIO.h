@@ -11,6 +11,7 @@
  */
 
 #include "DataFile.h"
+#include "EventLog.h"
 #include "ServerASIO.h"
 #include "Population.h"
 #include "Preferences.h"
@@ -38,15 +39,20 @@ public:
     int Process(const std::string &parameterFile, const std::string &outputDirectory, const std::string &startingPopulation);
 
     static void ApplyGenome(const std::string &inputGenome, const std::string &inputXML, const std::string &outputXML);
+    static int ApplyPopulation(const std::string &inputPopulation, const std::string &inputXML, const std::string &outputDirectory, const std::string &outputFile, size_t count, size_t threadCount);
 
     void SetLogLevel(int logLevel) { m_logLevel = logLevel; }
     void SetServerPort(int port);
+    void SetRandomSeed(uint64_t randomSeed) { m_randomSeed = randomSeed; m_randomSeedSet = true; }
+    void SetEventLogFile(const std::string &eventLogFile) { m_eventLogFile = eventLogFile; }
+    void SetReplayFile(const std::string &replayFile) { m_replayFile = replayFile; }
 
     static std::string ConvertAddressPortToString(uint32_t address, uint16_t port);
     static std::string ConvertAddressToString(uint32_t address);
     static std::string ToString(const char * const printfFormatString, ...);
 
     void handleRequestGenome(MessageASIO message);
+    void handleRelayRequestGenome(MessageASIO message);
     void handleRequestXML(MessageASIO message);
     void handleScore(MessageASIO message);
 
@@ -131,6 +137,13 @@ private:
 
     Preferences m_preferences;
     Random m_random;
+    uint64_t m_randomSeed = 0;
+    bool m_randomSeedSet = false;
+
+    std::string m_eventLogFile;
+    std::string m_replayFile;
+    EventLog m_eventLog;
+    EventLog m_replayLog;
 };
 
 #endif
@@ -0,0 +1,76 @@
+/*
+ *  GeneArena.cpp
+ *  AsynchronousGA
+ *
+ *  Created by Bill Sellers on 19/10/2026.
+ *  Copyright 2026 Bill Sellers. All rights reserved.
+ *
+ */
+
+#include "GeneArena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+GeneArena::GeneArena()
+{
+}
+
+// set the genome length and allocate the storage
+// this removes everything that is currently in the arena
+void GeneArena::Initialise(size_t genomeLength, size_t capacity)
+{
+    const size_t doublesPerLine = kAlignment / sizeof(double);
+    m_GenomeLength = genomeLength;
+    m_Stride = ((genomeLength + doublesPerLine - 1) / doublesPerLine) * doublesPerLine;
+    m_Storage.clear();
+    m_Genes = nullptr;
+    m_Fitness.clear();
+    m_FreeSlots.clear();
+    m_Capacity = 0;
+    m_Used = 0;
+    Reserve(capacity);
+}
+
+// grow the arena so it can hold at least capacity genomes
+// the slot numbers do not change but any gene pointers will be invalidated
+void GeneArena::Reserve(size_t capacity)
+{
+    if (capacity <= m_Capacity) return;
+    const size_t doublesPerLine = kAlignment / sizeof(double);
+    std::vector<double> storage(capacity * m_Stride + doublesPerLine);
+    uintptr_t address = reinterpret_cast<uintptr_t>(storage.data());
+    size_t offset = ((kAlignment - address % kAlignment) % kAlignment) / sizeof(double);
+    double *genes = storage.data() + offset;
+    if (m_Genes) std::copy_n(m_Genes, m_Used * m_Stride, genes);
+    m_Storage.swap(storage);
+    m_Genes = genes;
+    m_Fitness.resize(capacity);
+    m_FreeSlots.reserve(capacity);
+    m_Capacity = capacity;
+}
+
+// empty the arena but keep the storage
+void GeneArena::Clear()
+{
+    m_FreeSlots.clear();
+    m_Used = 0;
+}
+
+// get an unused slot, growing the arena if necessary
+size_t GeneArena::Allocate()
+{
+    if (m_FreeSlots.size())
+    {
+        size_t slot = m_FreeSlots.back();
+        m_FreeSlots.pop_back();
+        return slot;
+    }
+    if (m_Used == m_Capacity) Reserve(std::max(size_t(16), m_Capacity * 2));
+    return m_Used++;
+}
+
+void GeneArena::Free(size_t slot)
+{
+    m_FreeSlots.push_back(slot);
+}
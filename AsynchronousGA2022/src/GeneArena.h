@@ -0,0 +1,55 @@
+/*
+ *  GeneArena.h
+ *  AsynchronousGA
+ *
+ *  Created by Bill Sellers on 19/10/2026.
+ *  Copyright 2026 Bill Sellers. All rights reserved.
+ *
+ */
+
+#ifndef GENEARENA_H
+#define GENEARENA_H
+
+#include <vector>
+#include <cstddef>
+
+// Storage for the genes of a whole population in a single block. Each genome
+// occupies a slot which is a row of the block, and the rows are padded so that
+// every one starts on a cache line. The fitness of each slot is held in a
+// parallel array. Slots that are freed are reused by the next Allocate so once
+// the arena has reached the population size it does not allocate any more.
+class GeneArena
+{
+public:
+    GeneArena();
+
+    void Initialise(size_t genomeLength, size_t capacity);
+    void Reserve(size_t capacity);
+    void Clear();
+
+    size_t Allocate();
+    void Free(size_t slot);
+
+    double *GetGenes(size_t slot) { return m_Genes + slot * m_Stride; }
+    const double *GetGenes(size_t slot) const { return m_Genes + slot * m_Stride; }
+    double GetFitness(size_t slot) const { return m_Fitness[slot]; }
+    void SetFitness(size_t slot, double fitness) { m_Fitness[slot] = fitness; }
+
+    size_t GetGenomeLength() const { return m_GenomeLength; }
+    size_t GetCapacity() const { return m_Capacity; }
+    size_t GetStride() const { return m_Stride; }
+
+private:
+    static const size_t kAlignment = 64; // bytes
+
+    std::vector<double> m_Storage; // oversized so that m_Genes can be aligned
+    double *m_Genes = nullptr;
+    std::vector<double> m_Fitness;
+    std::vector<size_t> m_FreeSlots;
+    size_t m_GenomeLength = 0;
+    size_t m_Stride = 0;
+    size_t m_Capacity = 0;
+    size_t m_Used = 0; // slots below this have been handed out at least once
+};
+
+#endif // GENEARENA_H
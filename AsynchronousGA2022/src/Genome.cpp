@@ -15,6 +15,7 @@
 #include <limits>
 
 #include "Genome.h"
+#include "GenomeWriter.h"
 #include "Random.h"
 
 // constructor
@@ -25,55 +26,36 @@ Genome::Genome()
 Genome::Genome(const Genome &in)
 {
     mGenes = in.mGenes;
-    mLowBounds = in.mLowBounds;
-    mHighBounds = in.mHighBounds;
-    mGaussianSDs = in.mGaussianSDs;
-    mCircularMutationFlags = in.mCircularMutationFlags;
-    mGenomeType = in.mGenomeType;
-    mGlobalCircularMutationFlag = in.mGlobalCircularMutationFlag;
+    mSchema = in.mSchema;
     mFitness = in.mFitness;
 }
 
-Genome::Genome(Genome &&in)
+Genome::Genome(Genome &&in) noexcept
 {
-    mGenes = in.mGenes;
-    mLowBounds = in.mLowBounds;
-    mHighBounds = in.mHighBounds;
-    mGaussianSDs = in.mGaussianSDs;
-    mCircularMutationFlags = in.mCircularMutationFlags;
-    mGenomeType = in.mGenomeType;
-    mGlobalCircularMutationFlag = in.mGlobalCircularMutationFlag;
+    mGenes = std::move(in.mGenes);
+    mSchema = std::move(in.mSchema);
     mFitness = in.mFitness;
 }
 
 // define = operators
+// the copy reuses the existing gene storage if it is big enough
 Genome &Genome::operator=(const Genome &in)
 {
     if (&in != this)
     {
         mGenes = in.mGenes;
-        mLowBounds = in.mLowBounds;
-        mHighBounds = in.mHighBounds;
-        mGaussianSDs = in.mGaussianSDs;
-        mCircularMutationFlags = in.mCircularMutationFlags;
-        mGenomeType = in.mGenomeType;
-        mGlobalCircularMutationFlag = in.mGlobalCircularMutationFlag;
+        mSchema = in.mSchema;
         mFitness = in.mFitness;
     }
     return *this;
 }
 
-Genome &Genome::operator=(Genome &&in)
+Genome &Genome::operator=(Genome &&in) noexcept
 {
     if (&in != this)
     {
-        mGenes = in.mGenes;
-        mLowBounds = in.mLowBounds;
-        mHighBounds = in.mHighBounds;
-        mGaussianSDs = in.mGaussianSDs;
-        mCircularMutationFlags = in.mCircularMutationFlags;
-        mGenomeType = in.mGenomeType;
-        mGlobalCircularMutationFlag = in.mGlobalCircularMutationFlag;
+        mGenes = std::move(in.mGenes);
+        mSchema = std::move(in.mSchema);
         mFitness = in.mFitness;
     }
     return *this;
@@ -82,26 +64,21 @@ Genome &Genome::operator=(Genome &&in)
 void Genome::Clear()
 {
     mGenes.clear();
-    mLowBounds.clear();
-    mHighBounds.clear();
-    mGaussianSDs.clear();
-    mCircularMutationFlags.clear();
-    mGenomeType = IndividualRanges;
-    mGlobalCircularMutationFlag = false;
+    mSchema.reset();
     mFitness = -std::numeric_limits<double>::max();
 }
 
 // randomise the genome
 void Genome::Randomise(Random *random)
 {
-    switch (mGenomeType)
+    switch (mSchema->GetGenomeType())
     {
     case IndividualRanges:
     case IndividualCircularMutation:
         for (size_t i = 0; i < mGenes.size(); i++)
         {
-            if (mGaussianSDs[i] != 0)
-                mGenes[i] = random->RandomDouble(mLowBounds[i], mHighBounds[i]);
+            if (mSchema->GetGaussianSD(i) != 0)
+                mGenes[i] = random->RandomDouble(mSchema->GetLowBound(i), mSchema->GetHighBound(i));
         }
         break;
     }
@@ -116,75 +93,33 @@ bool Genome::operator<(const Genome &in)
     return false;
 }
 
-// get the value of the circular mutation flag for a gene
-bool Genome::GetCircularMutation(int i)
-{
-    bool v = 0;
-
-    switch (mGenomeType)
-    {
-    case IndividualRanges:
-        v = mGlobalCircularMutationFlag;
-        break;
-
-    case IndividualCircularMutation:
-        v = mCircularMutationFlags[i];
-        break;
-    }
-
-    return v;
-}
-
 // set the value of the circular mutation flag for a gene
+// the schema is shared so this replaces it with a modified copy
 void Genome::SetCircularMutation(size_t i, bool circularFlag)
 {
-    switch (mGenomeType)
-    {
-    case IndividualRanges:
-        mGlobalCircularMutationFlag = circularFlag;
-        break;
+    if (mSchema->GetCircularMutation(i) == circularFlag) return;
+    mSchema = mSchema->WithCircularMutation(i, circularFlag);
+}
 
-    case IndividualCircularMutation:
-        mCircularMutationFlags[i] = circularFlag;
-        break;
-    }
+void Genome::SetGlobalCircularMutationFlag(bool circularFlag)
+{
+    if (mSchema->GetGlobalCircularMutationFlag() == circularFlag) return;
+    mSchema = mSchema->WithGlobalCircularMutationFlag(circularFlag);
 }
 
 
 // output to a stream
+// GenomeWriter does the formatting so that this matches the population files exactly
 std::ostream& operator<<(std::ostream &out, const Genome &g)
 {
-    switch (g.mGenomeType)
-    {
-    case Genome::IndividualRanges:
-        out << g.mGenomeType << "\n";
-        out << g.mGenes.size() << "\n";
-        for (size_t i = 0; i < g.mGenes.size(); i++)
-        {
-            out << std::scientific << std::setprecision(18) << g.mGenes[i] << "\t" <<
-                   std::defaultfloat << std::setprecision(8) << g.mLowBounds[i] << "\t" <<
-                   g.mHighBounds[i] << "\t" << g.mGaussianSDs[i] << "\n";
-        }
-        out << std::scientific << std::setprecision(18) << g.mFitness << std::defaultfloat << "\t0\t0\t0\t0\n";
-        break;
-
-    case Genome::IndividualCircularMutation:
-        out << g.mGenomeType << "\n";
-        out << g.mGenes.size() << "\n";
-        for (size_t i = 0; i < g.mGenes.size(); i++)
-        {
-            out << std::scientific << std::setprecision(18) << g.mGenes[i] << "\t" <<
-                   std::defaultfloat << std::setprecision(8) << g.mLowBounds[i] << "\t" <<
-                   g.mHighBounds[i] << "\t" << g.mGaussianSDs[i] << "\t" << g.mCircularMutationFlags[i] << "\n";
-        }
-        out << std::scientific << std::setprecision(18) << g.mFitness << std::defaultfloat << "\t0\t0\t0\t0\n";
-        break;
-    }
-
+    GenomeWriter writer(&out, 1 << 16);
+    writer.WriteGenome(g.mGenes.data(), g.mGenes.size(), g.mFitness, g.mSchema);
+    writer.Flush();
     return out;
 }
 
 // input from a stream
+// this always creates a new schema so use SetSchema to share it if it matches an existing one
 std::istream& operator>>(std::istream &in, Genome &g)
 {
     int genomeType;
@@ -196,31 +131,70 @@ std::istream& operator>>(std::istream &in, Genome &g)
 
     g.Clear();
     g.mGenes.resize(genomeLength);
-    g.mLowBounds.resize(genomeLength);
-    g.mHighBounds.resize(genomeLength);
-    g.mGaussianSDs.resize(genomeLength);
-    g.mCircularMutationFlags.resize(genomeLength);
+    std::vector<double> lowBounds(genomeLength);
+    std::vector<double> highBounds(genomeLength);
+    std::vector<double> gaussianSDs(genomeLength);
+    std::vector<char> circularMutationFlags(genomeLength);
 
-    g.mGenomeType = (Genome::GenomeType)genomeType;
-    switch (g.mGenomeType)
+    switch (Genome::GenomeType(genomeType))
     {
     case Genome::IndividualRanges:
         for (size_t i = 0; i < genomeLength; i++)
-            in >> g.mGenes[i] >> g.mLowBounds[i] >> g.mHighBounds[i] >> g.mGaussianSDs[i];
+            in >> g.mGenes[i] >> lowBounds[i] >> highBounds[i] >> gaussianSDs[i];
         in >> g.mFitness >> dummy >> dummy >> dummy >> dummy;
         break;
 
     case Genome::IndividualCircularMutation:
         for (size_t i = 0; i < genomeLength; i++)
-            in >> g.mGenes[i] >> g.mLowBounds[i] >> g.mHighBounds[i] >> g.mGaussianSDs[i] >> g.mCircularMutationFlags[i];
+            in >> g.mGenes[i] >> lowBounds[i] >> highBounds[i] >> gaussianSDs[i] >> circularMutationFlags[i];
         in >> g.mFitness >> dummy >> dummy >> dummy >> dummy;
         break;
 
     }
 
+    g.mSchema = std::make_shared<const GenomeSchema>(Genome::GenomeType(genomeType), std::move(lowBounds), std::move(highBounds),
+                                                     std::move(gaussianSDs), std::move(circularMutationFlags), false);
     return in;
 }
 
+GenomeSchema::GenomeSchema(Genome::GenomeType genomeType, std::vector<double> &&lowBounds, std::vector<double> &&highBounds,
+                           std::vector<double> &&gaussianSDs, std::vector<char> &&circularMutationFlags, bool globalCircularMutationFlag)
+{
+    mLowBounds = std::move(lowBounds);
+    mHighBounds = std::move(highBounds);
+    mGaussianSDs = std::move(gaussianSDs);
+    mCircularMutationFlags = std::move(circularMutationFlags);
+    mGenomeType = genomeType;
+    mGlobalCircularMutationFlag = globalCircularMutationFlag;
+    for (size_t i = 0; i < mLowBounds.size(); i++)
+    {
+        if (mLowBounds[i] < mHighBounds[i]) mMutableLoci.push_back(uint32_t(i));
+        else mFixedLoci.push_back(uint32_t(i));
+    }
+}
+
+std::shared_ptr<const GenomeSchema> GenomeSchema::WithCircularMutation(size_t i, bool circularFlag) const
+{
+    if (mGenomeType == Genome::IndividualRanges) return WithGlobalCircularMutationFlag(circularFlag);
+    std::shared_ptr<GenomeSchema> schema = std::make_shared<GenomeSchema>(*this);
+    schema->mCircularMutationFlags[i] = circularFlag;
+    return schema;
+}
+
+std::shared_ptr<const GenomeSchema> GenomeSchema::WithGlobalCircularMutationFlag(bool circularFlag) const
+{
+    std::shared_ptr<GenomeSchema> schema = std::make_shared<GenomeSchema>(*this);
+    schema->mGlobalCircularMutationFlag = circularFlag;
+    return schema;
+}
+
+bool GenomeSchema::operator==(const GenomeSchema &in) const
+{
+    return mGenomeType == in.mGenomeType && mGlobalCircularMutationFlag == in.mGlobalCircularMutationFlag &&
+           mLowBounds == in.mLowBounds && mHighBounds == in.mHighBounds && mGaussianSDs == in.mGaussianSDs &&
+           mCircularMutationFlags == in.mCircularMutationFlags;
+}
+
 //bool GenomeFitnessLessThan(Genome *g1, Genome *g2)
 //{
 //    if (g1->GetFitness() < g2->GetFitness()) return true;
@@ -13,8 +13,11 @@
 #include <iostream>
 #include <vector>
 #include <limits>
+#include <memory>
+#include <cstdint>
 
 class Random;
+class GenomeSchema;
 
 class Genome
 {
@@ -22,9 +25,9 @@ public:
 
     Genome();
     Genome(const Genome &g);
-    Genome(Genome &&g);
+    Genome(Genome &&g) noexcept;
     Genome& operator=(const Genome &g);
-    Genome& operator=(Genome &&g);
+    Genome& operator=(Genome &&g) noexcept;
 
     enum GenomeType
     {
@@ -34,20 +37,23 @@ public:
 
     double GetGene(size_t i) const { return mGenes[i]; }
     size_t GetGenomeLength() const { return mGenes.size(); }
-    double GetHighBound(size_t i) const { return mHighBounds[i]; }
-    double GetLowBound(size_t i) const { return mLowBounds[i]; }
-    double GetGaussianSD(size_t i) const { return mGaussianSDs[i]; }
+    inline double GetHighBound(size_t i) const;
+    inline double GetLowBound(size_t i) const;
+    inline double GetGaussianSD(size_t i) const;
     double GetFitness() const { return mFitness; }
-    GenomeType GetGenomeType() const { return mGenomeType; }
+    inline GenomeType GetGenomeType() const;
     std::vector<double> *GetGenes() { return &mGenes; }
-    bool GetCircularMutation(int i);
-    bool GetGlobalCircularMutationFlag() { return mGlobalCircularMutationFlag; }
+    const std::vector<double> *GetGenes() const { return &mGenes; }
+    const std::shared_ptr<const GenomeSchema> &GetSchema() const { return mSchema; }
+    inline bool GetCircularMutation(int i);
+    inline bool GetGlobalCircularMutationFlag();
 
     void Randomise(Random *random);
     void SetGene(size_t i, double value) { mGenes[i] = value; }
     void SetFitness(double fitness) { mFitness = fitness; }
+    void SetSchema(const std::shared_ptr<const GenomeSchema> &schema) { mSchema = schema; }
     void SetCircularMutation(size_t i, bool circularFlag);
-    void SetGlobalCircularMutationFlag(bool circularFlag) { mGlobalCircularMutationFlag = circularFlag; }
+    void SetGlobalCircularMutationFlag(bool circularFlag);
     void Clear();
 
     bool operator<(const Genome &in);
@@ -58,15 +64,56 @@ public:
 private:
 
     std::vector<double> mGenes;
+    std::shared_ptr<const GenomeSchema> mSchema; // shared by all the genomes with the same bounds
+    double mFitness = -std::numeric_limits<double>::max();
+};
+
+// The per gene information that does not change between individuals. It is immutable once
+// created so it can be shared between genomes, and changing a flag creates a new schema.
+class GenomeSchema
+{
+public:
+    GenomeSchema(Genome::GenomeType genomeType, std::vector<double> &&lowBounds, std::vector<double> &&highBounds,
+                 std::vector<double> &&gaussianSDs, std::vector<char> &&circularMutationFlags, bool globalCircularMutationFlag);
+
+    size_t GetGenomeLength() const { return mLowBounds.size(); }
+    double GetHighBound(size_t i) const { return mHighBounds[i]; }
+    double GetLowBound(size_t i) const { return mLowBounds[i]; }
+    double GetGaussianSD(size_t i) const { return mGaussianSDs[i]; }
+    char GetCircularMutationFlag(size_t i) const { return mCircularMutationFlags[i]; }
+    const double *GetHighBounds() const { return mHighBounds.data(); }
+    const double *GetLowBounds() const { return mLowBounds.data(); }
+    const double *GetGaussianSDs() const { return mGaussianSDs.data(); }
+    const char *GetCircularMutationFlags() const { return mCircularMutationFlags.data(); }
+    const std::vector<uint32_t> &GetMutableLoci() const { return mMutableLoci; }
+    const std::vector<uint32_t> &GetFixedLoci() const { return mFixedLoci; }
+    Genome::GenomeType GetGenomeType() const { return mGenomeType; }
+    bool GetGlobalCircularMutationFlag() const { return mGlobalCircularMutationFlag; }
+    bool GetCircularMutation(size_t i) const { return mGenomeType == Genome::IndividualCircularMutation ? mCircularMutationFlags[i] != 0 : mGlobalCircularMutationFlag; }
+
+    std::shared_ptr<const GenomeSchema> WithCircularMutation(size_t i, bool circularFlag) const;
+    std::shared_ptr<const GenomeSchema> WithGlobalCircularMutationFlag(bool circularFlag) const;
+
+    bool operator==(const GenomeSchema &in) const;
+
+private:
     std::vector<double> mLowBounds;
     std::vector<double> mHighBounds;
     std::vector<double> mGaussianSDs;
     std::vector<char> mCircularMutationFlags;
-    GenomeType mGenomeType = IndividualRanges;
+    std::vector<uint32_t> mMutableLoci; // genes with low < high
+    std::vector<uint32_t> mFixedLoci; // genes with low >= high which are always set to low
+    Genome::GenomeType mGenomeType = Genome::IndividualRanges;
     bool mGlobalCircularMutationFlag = false;
-    double mFitness = -std::numeric_limits<double>::max();
 };
 
+inline double Genome::GetHighBound(size_t i) const { return mSchema->GetHighBound(i); }
+inline double Genome::GetLowBound(size_t i) const { return mSchema->GetLowBound(i); }
+inline double Genome::GetGaussianSD(size_t i) const { return mSchema->GetGaussianSD(i); }
+inline Genome::GenomeType Genome::GetGenomeType() const { return mSchema ? mSchema->GetGenomeType() : IndividualRanges; }
+inline bool Genome::GetCircularMutation(int i) { return mSchema->GetCircularMutation(size_t(i)); }
+inline bool Genome::GetGlobalCircularMutationFlag() { return mSchema ? mSchema->GetGlobalCircularMutationFlag() : false; }
+
 //bool GenomeFitnessLessThan(Genome *g1, Genome *g2);
 
 #endif // GENOME_H
@@ -0,0 +1,140 @@
+/*
+ *  GenomeWriter.cpp
+ *  AsynchronousGA
+ *
+ *  Created by Bill Sellers on 19/10/2026.
+ *  Copyright 2026 Bill Sellers. All rights reserved.
+ *
+ */
+
+#include "GenomeWriter.h"
+#include "Genome.h"
+
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+
+// longest outputs are -d.ddddddddddddddddddde+ddd and -d.ddddddde+ddd
+static const size_t kMaxScientificLength = 32;
+static const size_t kMaxGeneralLength = 24;
+
+GenomeWriter::GenomeWriter(std::ostream *out, size_t bufferSize)
+{
+    m_Out = out;
+    m_Buffer.resize(bufferSize < 256 ? 256 : bufferSize);
+}
+
+GenomeWriter::~GenomeWriter()
+{
+    try { Flush(); }
+    catch (...) {} // call Flush explicitly to see errors
+}
+
+void GenomeWriter::Flush()
+{
+    if (m_Used == 0) return;
+    size_t used = m_Used;
+    m_Used = 0;
+    m_Out->write(m_Buffer.data(), std::streamsize(used));
+}
+
+// returns a pointer to at least n free bytes at the end of the buffer
+char *GenomeWriter::Space(size_t n)
+{
+    if (m_Used + n > m_Buffer.size())
+    {
+        Flush();
+        if (n > m_Buffer.size()) m_Buffer.resize(n);
+    }
+    return m_Buffer.data() + m_Used;
+}
+
+// the same as %.18e
+void GenomeWriter::AppendScientific(double value)
+{
+    char *ptr = Space(kMaxScientificLength);
+#if defined(__cpp_lib_to_chars)
+    m_Used = size_t(std::to_chars(ptr, ptr + kMaxScientificLength, value, std::chars_format::scientific, 18).ptr - m_Buffer.data());
+#else
+    m_Used += size_t(std::snprintf(ptr, kMaxScientificLength, "%.18e", value));
+#endif
+}
+
+// the same as %.8g which is what iostreams use for defaultfloat with precision 8
+void GenomeWriter::AppendGeneral(double value, std::string *text)
+{
+    char buffer[kMaxGeneralLength];
+#if defined(__cpp_lib_to_chars)
+    size_t length = size_t(std::to_chars(buffer, buffer + kMaxGeneralLength, value, std::chars_format::general, 8).ptr - buffer);
+#else
+    size_t length = size_t(std::snprintf(buffer, kMaxGeneralLength, "%.8g", value));
+#endif
+    text->append(buffer, length);
+}
+
+// format the bounds once for all the genomes that use this schema
+void GenomeWriter::SetSchema(const std::shared_ptr<const GenomeSchema> &schema)
+{
+    if (schema == m_Schema) return;
+    m_Schema = schema;
+    size_t genomeLength = schema->GetGenomeLength();
+    bool writeFlags = schema->GetGenomeType() == Genome::IndividualCircularMutation;
+    m_SchemaText.clear();
+    m_SchemaOffsets.resize(genomeLength + 1);
+    for (size_t i = 0; i < genomeLength; i++)
+    {
+        m_SchemaOffsets[i] = m_SchemaText.size();
+        m_SchemaText.push_back('\t');
+        AppendGeneral(schema->GetLowBound(i), &m_SchemaText);
+        m_SchemaText.push_back('\t');
+        AppendGeneral(schema->GetHighBound(i), &m_SchemaText);
+        m_SchemaText.push_back('\t');
+        AppendGeneral(schema->GetGaussianSD(i), &m_SchemaText);
+        if (writeFlags)
+        {
+            m_SchemaText.push_back('\t');
+            m_SchemaText.push_back(schema->GetCircularMutationFlag(i)); // written as a raw char to match the old output
+        }
+        m_SchemaText.push_back('\n');
+    }
+    m_SchemaOffsets[genomeLength] = m_SchemaText.size();
+}
+
+void GenomeWriter::WriteCount(size_t count)
+{
+    char *ptr = Space(kMaxGeneralLength);
+    ptr = std::to_chars(ptr, ptr + kMaxGeneralLength, count).ptr;
+    *ptr++ = '\n';
+    m_Used = size_t(ptr - m_Buffer.data());
+}
+
+void GenomeWriter::WriteGenome(const Genome &genome)
+{
+    WriteGenome(genome.GetGenes()->data(), genome.GetGenomeLength(), genome.GetFitness(), genome.GetSchema());
+}
+
+void GenomeWriter::WriteGenome(const double *genes, size_t genomeLength, double fitness, const std::shared_ptr<const GenomeSchema> &schema)
+{
+    SetSchema(schema);
+
+    char *ptr = Space(2 * kMaxGeneralLength);
+    ptr = std::to_chars(ptr, ptr + kMaxGeneralLength, int(schema->GetGenomeType())).ptr;
+    *ptr++ = '\n';
+    ptr = std::to_chars(ptr, ptr + kMaxGeneralLength, genomeLength).ptr;
+    *ptr++ = '\n';
+    m_Used = size_t(ptr - m_Buffer.data());
+
+    const char *schemaText = m_SchemaText.data();
+    for (size_t i = 0; i < genomeLength; i++)
+    {
+        AppendScientific(genes[i]);
+        size_t length = m_SchemaOffsets[i + 1] - m_SchemaOffsets[i];
+        std::memcpy(Space(length), schemaText + m_SchemaOffsets[i], length);
+        m_Used += length;
+    }
+
+    AppendScientific(fitness);
+    static const char fitnessTail[] = "\t0\t0\t0\t0\n";
+    std::memcpy(Space(sizeof(fitnessTail) - 1), fitnessTail, sizeof(fitnessTail) - 1);
+    m_Used += sizeof(fitnessTail) - 1;
+}
@@ -0,0 +1,58 @@
+/*
+ *  GenomeWriter.h
+ *  AsynchronousGA
+ *
+ *  Created by Bill Sellers on 19/10/2026.
+ *  Copyright 2026 Bill Sellers. All rights reserved.
+ *
+ */
+
+#ifndef GENOMEWRITER_H
+#define GENOMEWRITER_H
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstddef>
+
+class Genome;
+class GenomeSchema;
+
+// Formats genomes in the text layout used by the population files into a buffer that is
+// passed to the stream in large blocks. The per gene bounds only depend on the schema so
+// they are formatted once and reused for every genome that shares the same schema.
+// The output is byte for byte the same as the old iostream formatting (%.18e for the genes
+// and fitness and %.8g for the bounds).
+class GenomeWriter
+{
+public:
+    GenomeWriter(std::ostream *out, size_t bufferSize = 1 << 20);
+    ~GenomeWriter();
+    GenomeWriter(const GenomeWriter &) = delete;
+    GenomeWriter &operator=(const GenomeWriter &) = delete;
+
+    void WriteCount(size_t count);
+    void WriteGenome(const Genome &genome);
+    void WriteGenome(const double *genes, size_t genomeLength, double fitness, const std::shared_ptr<const GenomeSchema> &schema);
+
+    // passes any buffered text to the stream (this is also done by the destructor)
+    void Flush();
+
+private:
+    char *Space(size_t n);
+    void AppendScientific(double value);
+    void AppendGeneral(double value, std::string *text);
+    void SetSchema(const std::shared_ptr<const GenomeSchema> &schema);
+
+    std::ostream *m_Out = nullptr;
+    std::vector<char> m_Buffer;
+    size_t m_Used = 0;
+    size_t m_FlushSize = 0;
+
+    std::shared_ptr<const GenomeSchema> m_Schema; // kept so the cache cannot outlive the schema
+    std::string m_SchemaText; // the bounds part of every gene line
+    std::vector<size_t> m_SchemaOffsets; // gene i is m_SchemaText[m_SchemaOffsets[i]] to m_SchemaText[m_SchemaOffsets[i + 1]]
+};
+
+#endif // GENOMEWRITER_H
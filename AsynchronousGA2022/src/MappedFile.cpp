@@ -0,0 +1,84 @@
+/*
+ *  MappedFile.cpp
+ *  AsynchronousGA
+ *
+ *  Created by Bill Sellers on 19/10/2026.
+ *  Copyright 2026 Bill Sellers. All rights reserved.
+ *
+ */
+
+#include "MappedFile.h"
+
+#if defined(_WIN32) || defined(WIN32)
+#include <fstream>
+#include <filesystem>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+{
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+// returns 0 on success
+int MappedFile::Open(const char *filename)
+{
+    Close();
+#if defined(_WIN32) || defined(WIN32)
+    std::ifstream in(std::filesystem::u8path(filename), std::ios::binary | std::ios::ate);
+    if (!in) return __LINE__;
+    std::streamoff size = in.tellg();
+    if (size < 0) return __LINE__;
+    m_Buffer.resize(size_t(size));
+    in.seekg(0);
+    if (size && !in.read(m_Buffer.data(), size)) return __LINE__;
+    m_Data = m_Buffer.data();
+    m_Size = m_Buffer.size();
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return __LINE__;
+    struct stat fileStat;
+    if (fstat(fd, &fileStat))
+    {
+        close(fd);
+        return __LINE__;
+    }
+    m_Size = size_t(fileStat.st_size);
+    if (m_Size)
+    {
+        void *map = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED)
+        {
+            close(fd);
+            m_Size = 0;
+            return __LINE__;
+        }
+        madvise(map, m_Size, MADV_SEQUENTIAL);
+        m_Map = map;
+        m_Data = static_cast<const char *>(map);
+    }
+    close(fd); // the mapping stays valid after the file is closed
+#endif
+    return 0;
+}
+
+void MappedFile::Close()
+{
+#if defined(_WIN32) || defined(WIN32)
+    m_Buffer.clear();
+    m_Buffer.shrink_to_fit();
+#else
+    if (m_Map) munmap(m_Map, m_Size);
+    m_Map = nullptr;
+#endif
+    m_Data = nullptr;
+    m_Size = 0;
+}
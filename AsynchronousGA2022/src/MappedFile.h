@@ -0,0 +1,43 @@
+/*
+ *  MappedFile.h
+ *  AsynchronousGA
+ *
+ *  Created by Bill Sellers on 19/10/2026.
+ *  Copyright 2026 Bill Sellers. All rights reserved.
+ *
+ */
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <vector>
+#include <cstddef>
+
+// Read only access to the whole of a file. On POSIX systems the file is memory
+// mapped so nothing is copied. Elsewhere the file is read into a buffer.
+// Note: the data are not zero terminated.
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    int Open(const char *filename);
+    void Close();
+
+    const char *GetData() const { return m_Data; }
+    size_t GetSize() const { return m_Size; }
+
+private:
+    const char *m_Data = nullptr;
+    size_t m_Size = 0;
+#if defined(_WIN32) || defined(WIN32)
+    std::vector<char> m_Buffer;
+#else
+    void *m_Map = nullptr;
+#endif
+};
+
+#endif // MAPPEDFILE_H
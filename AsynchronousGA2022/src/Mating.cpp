@@ -10,10 +10,19 @@
 #include "Mating.h"
 #include "Random.h"
 #include "Genome.h"
+#include "Population.h"
+#include "OffspringBatch.h"
 
 #include <iostream>
 #include <cmath>
 #include <memory>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 Mating::Mating(Random *random)
 {
@@ -23,31 +32,30 @@ Mating::Mating(Random *random)
 
 // mate two parents producing an offspring
 // some crossover *ALWAYS* occurs
-int Mating::Mate(Genome *parent1, Genome *parent2, Genome *offspring, Mating::CrossoverType type)
+int Mating::Mate(const double *parent1, const double *parent2, Genome *offspring, Mating::CrossoverType type)
 {
+    return Mate(parent1, parent2, offspring->GetGenes()->data(), offspring->GetGenomeLength(), type);
+}
 
-    int i;
-    int genomeLength = offspring->GetGenomeLength();
-
+// the offspring must not overlap either parent
+int Mating::Mate(const double *parent1, const double *parent2, double *offspring, size_t genomeLength, Mating::CrossoverType type)
+{
     switch (type)
     {
     case OnePoint:
     {
-        int crossoverPoint = m_random->RandomInt(1, genomeLength - 1);
-
-        for (i = 0; i < crossoverPoint; i++)
-            offspring->SetGene(i, parent1->GetGene(i));
-
-        for (i = crossoverPoint; i < genomeLength; i++)
-            offspring->SetGene(i, parent2->GetGene(i));
-
+        size_t crossoverPoint = size_t(m_random->RandomInt(1, int(genomeLength) - 1));
+        if (crossoverPoint > genomeLength) crossoverPoint = genomeLength; // only for very short genomes
+        std::memcpy(offspring, parent1, crossoverPoint * sizeof(double));
+        std::memcpy(offspring + crossoverPoint, parent2 + crossoverPoint, (genomeLength - crossoverPoint) * sizeof(double));
         break;
     }
 
     case Average:
     {
-        for (i = 0; i < genomeLength; i++)
-            offspring->SetGene(i, (parent1->GetGene(i) + parent2->GetGene(i)) / 2.0);
+        // multiplying by 0.5 is exact so this gives the same answer as dividing by 2 and vectorises
+        for (size_t i = 0; i < genomeLength; i++)
+            offspring[i] = (parent1[i] + parent2[i]) * 0.5;
         break;
     }
     }
@@ -57,9 +65,14 @@ int Mating::Mate(Genome *parent1, Genome *parent2, Genome *offspring, Mating::Cr
 // mutate an individual by adding a gaussian distributed double
 // if gaussianSD <= 0 then don't mutate
 int Mating::GaussianMutate(Genome *genome, double mutationChance, bool bounceMutation)
+{
+    return GaussianMutate(genome->GetGenes()->data(), *genome->GetSchema(), mutationChance, bounceMutation);
+}
+
+int Mating::GaussianMutate(double *genes, const GenomeSchema &schema, double mutationChance, bool bounceMutation)
 {
     double v = 0;
-    int genomeLength = genome->GetGenomeLength();
+    int genomeLength = int(schema.GetGenomeLength());
     int location;
     double r, w;
 
@@ -72,157 +85,282 @@ int Mating::GaussianMutate(Genome *genome, double mutationChance, bool bounceMut
     // gaussian mutator
     r = m_random->RandomUnitGaussian();
     location = m_random->RandomInt(0, genomeLength - 1);
-    while (genome->GetGaussianSD(location) > 0)
+    double low = schema.GetLowBound(location);
+    double high = schema.GetHighBound(location);
+    double sd = schema.GetGaussianSD(location);
+    bool circular = schema.GetCircularMutation(location);
+    while (sd > 0)
     {
-        if (genome->GetLowBound(location) >= genome->GetHighBound(location))
+        if (low >= high)
         {
-            genome->SetGene(location, genome->GetLowBound(location));
+            genes[location] = low;
             break;
         }
-        v = genome->GetGene(location) + r * genome->GetGaussianSD(location);
-        if (v < genome->GetLowBound(location))
+        v = genes[location] + r * sd;
+        if (v < low)
         {
-            if (genome->GetCircularMutation(location) == false)
+            if (circular == false)
             {
                 if (bounceMutation == false)
                 {
-                    v = genome->GetLowBound(location);
+                    v = low;
                 }
                 else
                 {
-                    w = genome->GetLowBound(location) - v; // must be positive
-                    w = fmod(w, genome->GetHighBound(location) - genome->GetLowBound(location));
-                    v = genome->GetLowBound(location) + w; // this must be less than genome->GetHighBound(location)
+                    w = low - v; // must be positive
+                    w = fmod(w, high - low);
+                    v = low + w; // this must be less than high
                 }
             }
             else
             {
-                w = v - genome->GetLowBound(location);
-                w = fmod(w, genome->GetHighBound(location) - genome->GetLowBound(location));
-                v = genome->GetHighBound(location) + w; // this is right because w must be negative and magnitude <= genome->GetHighBound(location) - genome->GetLowBound(location)
+                w = v - low;
+                w = fmod(w, high - low);
+                v = high + w; // this is right because w must be negative and magnitude <= high - low
             }
-            genome->SetGene(location, v);
+            genes[location] = v;
             break;
         }
-        if (v > genome->GetHighBound(location))
+        if (v > high)
         {
-            if (genome->GetCircularMutation(location) == false)
+            if (circular == false)
             {
                 if (bounceMutation == false)
                 {
-                    v = genome->GetHighBound(location);
+                    v = high;
                 }
                 else
                 {
-                    w = v - genome->GetHighBound(location); // must be positive
-                    w = fmod(w, genome->GetHighBound(location) - genome->GetLowBound(location));
-                    v = genome->GetHighBound(location) - w; // this must be higher than genome->GetLowBound(location)
+                    w = v - high; // must be positive
+                    w = fmod(w, high - low);
+                    v = high - w; // this must be higher than low
                 }
             }
             else
             {
-                w = v - genome->GetHighBound(location);
-                w = fmod(w, genome->GetHighBound(location) - genome->GetLowBound(location));
-                v = genome->GetLowBound(location) + w; // this is right because w must be positive and magnitude <= genome->GetHighBound(location) - genome->GetLowBound(location)
+                w = v - high;
+                w = fmod(w, high - low);
+                v = low + w; // this is right because w must be positive and magnitude <= high - low
             }
-            genome->SetGene(location, v);
+            genes[location] = v;
             break;
         }
-        genome->SetGene(location, v);
+        genes[location] = v;
     }
     return 1;
 }
 
+// The per gene mutation kernels are templates on the genome type and the range rules so that
+// the choices are made once per call rather than for every gene. For IndividualRanges every
+// gene uses the global circular flag. For IndividualCircularMutation each gene has its own flag
+// and the circular template argument is not used.
+
+// put a mutated value back into range
+// w is how far v is outside the range (negative when below) and w - trunc(w / range) * range is the same as fmod(w, range)
+// everything is written as selects so that the loops that use it can be vectorised
+// the final clamp is only there to catch rounding errors
+template <Genome::GenomeType genomeType, bool bounceMutation, bool circular>
+static inline double BringIntoRange(double v, double low, double high, char circularFlag)
+{
+    bool below = v < low;
+    bool outside = below || v > high;
+    double range = high - low;
+    double w = v - (below ? low : high);
+    double m = w - std::trunc(w / range) * range;
+    double circularValue = (below ? high : low) + m;
+    double fixedValue;
+    if constexpr (bounceMutation) fixedValue = (below ? low : high) - m;
+    else fixedValue = below ? low : high;
+    if constexpr (genomeType == Genome::IndividualCircularMutation) fixedValue = circularFlag ? circularValue : fixedValue;
+    else if constexpr (circular) fixedValue = circularValue;
+    fixedValue = std::min(std::max(fixedValue, low), high);
+    return outside ? fixedValue : v;
+}
+
+// add the deltas to the genes and apply the range rules
+// genes with low >= high are set to low and a zero delta leaves the gene alone
+template <Genome::GenomeType genomeType, bool bounceMutation, bool circular>
+static void ApplyGaussianDeltas(double *genes, const double *deltas, const double *lowBounds, const double *highBounds,
+                                const char *circularFlags, size_t genomeLength)
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d allOnes = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+    for (; i + 4 <= genomeLength; i += 4)
+    {
+        __m256d x = _mm256_loadu_pd(genes + i);
+        __m256d d = _mm256_loadu_pd(deltas + i);
+        __m256d low = _mm256_loadu_pd(lowBounds + i);
+        __m256d high = _mm256_loadu_pd(highBounds + i);
+
+        __m256d v = _mm256_add_pd(x, d);
+        __m256d below = _mm256_cmp_pd(v, low, _CMP_LT_OQ);
+        __m256d range = _mm256_sub_pd(high, low);
+        __m256d w = _mm256_sub_pd(v, _mm256_blendv_pd(high, low, below));
+        __m256d m = _mm256_sub_pd(w, _mm256_mul_pd(_mm256_round_pd(_mm256_div_pd(w, range), _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC), range));
+        __m256d circularValue = _mm256_add_pd(_mm256_blendv_pd(low, high, below), m);
+        __m256d fixedValue;
+        if constexpr (bounceMutation) fixedValue = _mm256_sub_pd(_mm256_blendv_pd(high, low, below), m);
+        else fixedValue = _mm256_blendv_pd(high, low, below);
+        if constexpr (genomeType == Genome::IndividualCircularMutation)
+        {
+            int32_t flags;
+            std::memcpy(&flags, circularFlags + i, sizeof(flags));
+            __m256i wide = _mm256_cvtepi8_epi64(_mm_cvtsi32_si128(flags));
+            __m256d circularMask = _mm256_xor_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(wide, _mm256_setzero_si256())), allOnes);
+            fixedValue = _mm256_blendv_pd(fixedValue, circularValue, circularMask);
+        }
+        else if constexpr (circular) fixedValue = circularValue;
+        fixedValue = _mm256_min_pd(_mm256_max_pd(fixedValue, low), high);
+        __m256d outside = _mm256_or_pd(below, _mm256_cmp_pd(v, high, _CMP_GT_OQ));
+        v = _mm256_blendv_pd(v, fixedValue, outside);
+
+        __m256d changed = _mm256_cmp_pd(d, zero, _CMP_NEQ_UQ);
+        __m256d result = _mm256_blendv_pd(x, v, changed);
+        result = _mm256_blendv_pd(result, low, _mm256_cmp_pd(low, high, _CMP_GE_OQ));
+        _mm256_storeu_pd(genes + i, result);
+    }
+#endif
+    for (; i < genomeLength; i++)
+    {
+        double low = lowBounds[i];
+        double high = highBounds[i];
+        double v = BringIntoRange<genomeType, bounceMutation, circular>(genes[i] + deltas[i], low, high, circularFlags ? circularFlags[i] : 0);
+        v = deltas[i] != 0 ? v : genes[i];
+        genes[i] = low >= high ? low : v;
+    }
+}
+
+// mutate the selected genes (which must all have low < high)
+template <Genome::GenomeType genomeType, bool bounceMutation, bool circular>
+static void MutateSelectedGenes(double *genes, const uint32_t *selected, const double *gaussians, size_t n, const double *lowBounds,
+                                const double *highBounds, const double *gaussianSDs, const char *circularFlags)
+{
+    for (size_t j = 0; j < n; j++)
+    {
+        uint32_t i = selected[j];
+        if (gaussianSDs[i] <= 0) continue;
+        genes[i] = BringIntoRange<genomeType, bounceMutation, circular>(genes[i] + gaussians[j] * gaussianSDs[i], lowBounds[i], highBounds[i],
+                                                                        circularFlags ? circularFlags[i] : 0);
+    }
+}
+
+// choose the kernel instance to match the genome once per call
+// kernelTemplate is a template with the arguments <genomeType, bounceMutation, circular>
+#define SELECT_MUTATION_KERNEL(kernelTemplate, genomeType, bounceMutation, circular) \
+    ((genomeType) == Genome::IndividualCircularMutation ? \
+        ((bounceMutation) ? &kernelTemplate<Genome::IndividualCircularMutation, true, false> : &kernelTemplate<Genome::IndividualCircularMutation, false, false>) : \
+        ((bounceMutation) ? ((circular) ? &kernelTemplate<Genome::IndividualRanges, true, true> : &kernelTemplate<Genome::IndividualRanges, true, false>) : \
+                            ((circular) ? &kernelTemplate<Genome::IndividualRanges, false, true> : &kernelTemplate<Genome::IndividualRanges, false, false>)))
+
 // mutate an individual by adding a gaussian distributed double
 // with a finite chance per gene
 // if gaussianSD <= 0 then don't mutate
+// the random numbers are generated in blocks and the genes are then updated in a single pass
 int Mating::MultipleGaussianMutate(Genome *genome, double mutationChance, bool bounceMutation)
 {
-    // use the mutation chance on each gene
+    return MultipleGaussianMutate(genome->GetGenes()->data(), *genome->GetSchema(), mutationChance, bounceMutation);
+}
 
-    int i;
-    double v = 0;
-    int genomeLength = genome->GetGenomeLength();
-    double r, w;
+int Mating::MultipleGaussianMutate(double *genes, const GenomeSchema &schema, double mutationChance, bool bounceMutation)
+{
+    if (mutationChance == 0) return 0;
 
+    size_t genomeLength = schema.GetGenomeLength();
+    const double *lowBounds = schema.GetLowBounds();
+    const double *highBounds = schema.GetHighBounds();
+    const double *gaussianSDs = schema.GetGaussianSDs();
+    const char *circularFlags = schema.GetGenomeType() == Genome::IndividualCircularMutation ? schema.GetCircularMutationFlags() : nullptr;
+
+    // choose the genes to mutate
+    m_uniforms.resize(genomeLength);
+    m_random->RandomUnitDoubles(m_uniforms.data(), genomeLength);
+    m_mutatedGenes.clear();
+    for (size_t i = 0; i < genomeLength; i++)
+    {
+        if (m_uniforms[i] < mutationChance && lowBounds[i] < highBounds[i]) m_mutatedGenes.push_back(uint32_t(i));
+    }
+
+    // and work out how much to change them by
+    size_t mutated = m_mutatedGenes.size();
+    m_gaussians.resize(mutated);
+    m_random->RandomUnitGaussians(m_gaussians.data(), mutated);
+    m_deltas.assign(genomeLength, 0.0);
+    for (size_t j = 0; j < mutated; j++)
+    {
+        uint32_t i = m_mutatedGenes[j];
+        if (gaussianSDs[i] > 0) m_deltas[i] = m_gaussians[j] * gaussianSDs[i];
+    }
+
+    auto kernel = SELECT_MUTATION_KERNEL(ApplyGaussianDeltas, schema.GetGenomeType(), bounceMutation, schema.GetGlobalCircularMutationFlag());
+    kernel(genes, m_deltas.data(), lowBounds, highBounds, circularFlags, genomeLength);
+    return int(mutated);
+}
+
+// mutate an individual in the same way as MultipleGaussianMutate
+// but rather than testing every gene the gap to the next mutated gene is drawn from a
+// geometric distribution so the cost depends on the number of mutations and not the genome length
+int Mating::GeometricSkipGaussianMutate(Genome *genome, double mutationChance, bool bounceMutation)
+{
+    return GeometricSkipGaussianMutate(genome->GetGenes()->data(), *genome->GetSchema(), mutationChance, bounceMutation);
+}
+
+int Mating::GeometricSkipGaussianMutate(double *genes, const GenomeSchema &schema, double mutationChance, bool bounceMutation)
+{
     if (mutationChance == 0) return 0;
 
-    // gaussian mutator
-    int mutated = 0;
-    for (i = 0; i < genomeLength; i++)
+    const double *lowBounds = schema.GetLowBounds();
+    const char *circularFlags = schema.GetGenomeType() == Genome::IndividualCircularMutation ? schema.GetCircularMutationFlags() : nullptr;
+
+    for (auto &&i : schema.GetFixedLoci()) genes[i] = lowBounds[i];
+
+    // choose the genes to mutate
+    const std::vector<uint32_t> &loci = schema.GetMutableLoci();
+    m_mutatedGenes.clear();
+    if (mutationChance >= 1.0)
+    {
+        m_mutatedGenes.assign(loci.begin(), loci.end());
+    }
+    else
     {
-        if (genome->GetLowBound(i) >= genome->GetHighBound(i))
+        double logFailureChance = std::log1p(-mutationChance);
+        uint64_t position = m_random->RandomGeometricGap(logFailureChance);
+        while (position < loci.size())
         {
-            genome->SetGene(i, genome->GetLowBound(i));
-            continue;
-        }
-        if (m_random->CoinFlip(mutationChance))
-        {
-            mutated++;
-            r = m_random->RandomUnitGaussian();
-            if (genome->GetGaussianSD(i) > 0)
-            {
-                v = genome->GetGene(i) + r * genome->GetGaussianSD(i);
-                if (v < genome->GetLowBound(i))
-                {
-                    if (genome->GetCircularMutation(i) == false)
-                    {
-                        if (bounceMutation == false)
-                        {
-                            v = genome->GetLowBound(i);
-                        }
-                        else
-                        {
-                            w = genome->GetLowBound(i) - v; // must be positive
-                            w = fmod(w, genome->GetHighBound(i) - genome->GetLowBound(i));
-                            v = genome->GetLowBound(i) + w; // this must be less than genome->GetHighBound(location)
-                        }
-                    }
-                    else
-                    {
-                        w = v - genome->GetLowBound(i);
-                        w = fmod(w, genome->GetHighBound(i) - genome->GetLowBound(i));
-                        v = genome->GetHighBound(i) + w; // this is right because w must be negative and magnitude <= genome->GetHighBound(location) - genome->GetLowBound(location)
-                    }
-                }
-                else
-                {
-                    if (v > genome->GetHighBound(i))
-                    {
-                        if (genome->GetCircularMutation(i) == false)
-                        {
-                            if (bounceMutation == false)
-                            {
-                                v = genome->GetHighBound(i);
-                            }
-                            else
-                            {
-                                w = v - genome->GetHighBound(i); // must be positive
-                                w = fmod(w, genome->GetHighBound(i) - genome->GetLowBound(i));
-                                v = genome->GetHighBound(i) - w; // this must be higher than genome->GetLowBound(location)
-                            }
-                        }
-                        else
-                        {
-                            w = v - genome->GetHighBound(i);
-                            w = fmod(w, genome->GetHighBound(i) - genome->GetLowBound(i));
-                            v = genome->GetLowBound(i) + w; // this is right because w must be positive and magnitude <= genome->GetHighBound(location) - genome->GetLowBound(location)
-                        }
-                    }
-                }
-                genome->SetGene(i, v);
-            }
+            m_mutatedGenes.push_back(loci[size_t(position)]);
+            position += 1 + m_random->RandomGeometricGap(logFailureChance);
         }
     }
-    return mutated;
+
+    // and mutate them
+    size_t mutated = m_mutatedGenes.size();
+    m_gaussians.resize(mutated);
+    m_random->RandomUnitGaussians(m_gaussians.data(), mutated);
+    auto kernel = SELECT_MUTATION_KERNEL(MutateSelectedGenes, schema.GetGenomeType(), bounceMutation, schema.GetGlobalCircularMutationFlag());
+    kernel(genes, m_mutatedGenes.data(), m_gaussians.data(), mutated, lowBounds, schema.GetHighBounds(), schema.GetGaussianSDs(), circularFlags);
+    return int(mutated);
+}
+
+// put genes first to last - 1 back inside the bounds of the locus they are now at
+static void ClampToBounds(double *genes, const GenomeSchema &schema, size_t first, size_t last)
+{
+    const double *lowBounds = schema.GetLowBounds();
+    const double *highBounds = schema.GetHighBounds();
+    for (size_t i = first; i < last; i++)
+        genes[i] = lowBounds[i] >= highBounds[i] ? lowBounds[i] : std::min(std::max(genes[i], lowBounds[i]), highBounds[i]);
 }
 
 // mutate an individual by inserting or deleting a gene
-int Mating::FrameShiftMutate(Genome *genome, double mutationChance)
+// if clampToBounds is set the genes that move are clamped to the bounds of their new locus
+int Mating::FrameShiftMutate(Genome *genome, double mutationChance, bool clampToBounds)
 {
-    int i;
-    int location;
-    int genomeLength = genome->GetGenomeLength();
+    return FrameShiftMutate(genome->GetGenes()->data(), *genome->GetSchema(), mutationChance, clampToBounds);
+}
+
+int Mating::FrameShiftMutate(double *genes, const GenomeSchema &schema, double mutationChance, bool clampToBounds)
+{
+    int genomeLength = int(schema.GetGenomeLength());
 
     if (mutationChance == 0) return 0;
     if (mutationChance < 1.0)
@@ -231,28 +369,34 @@ int Mating::FrameShiftMutate(Genome *genome, double mutationChance)
     }
 
     // insertion/deletion
-    location = m_random->RandomInt(0, genomeLength - 1);
+    int location = m_random->RandomInt(0, genomeLength - 1);
+    size_t moved = genomeLength - 1 > location ? size_t(genomeLength - 1 - location) : 0;
     if (m_random->CoinFlip(0.5))
     {
         // deletion
-        for (i = location; i < genomeLength - 1; i++)
-            genome->SetGene(i, genome->GetGene(i + 1));
+        std::memmove(genes + location, genes + location + 1, moved * sizeof(double));
+        if (clampToBounds) ClampToBounds(genes, schema, size_t(location), size_t(location) + moved);
     }
     else
     {
         // insertion
-        for (i = genomeLength - 2; i >= location; i--)
-            genome->SetGene(i + 1, genome->GetGene(i));
+        std::memmove(genes + location + 1, genes + location, moved * sizeof(double));
+        if (clampToBounds) ClampToBounds(genes, schema, size_t(location) + 1, size_t(location) + 1 + moved);
     }
     return 1;
 }
 
 // mutate an individual by duplicating a block and inserting it in a
 // random location
-int Mating::DuplicationMutate(Genome *genome, double mutationChance)
+// if clampToBounds is set the genes that are copied are clamped to the bounds of their new locus
+int Mating::DuplicationMutate(Genome *genome, double mutationChance, bool clampToBounds)
+{
+    return DuplicationMutate(genome->GetGenes()->data(), *genome->GetSchema(), mutationChance, clampToBounds);
+}
+
+int Mating::DuplicationMutate(double *genes, const GenomeSchema &schema, double mutationChance, bool clampToBounds)
 {
-    int i;
-    int genomeLength = genome->GetGenomeLength();
+    int genomeLength = int(schema.GetGenomeLength());
     int origin;
     int length;
     int insertion;
@@ -268,23 +412,55 @@ int Mating::DuplicationMutate(Genome *genome, double mutationChance)
     if (genomeLength - origin == 1) length = 1;
     else length = m_random->RandomInt(1, genomeLength - origin);
 
-    // make a copy
-    std::unique_ptr<double[]> store = std::make_unique<double[]>(length);
-    for (i = 0; i < length; i++)
-        store[i] = genome->GetGene(origin + i);
-
-    // and write the copy into the genome
+    // and write the copy into the genome stopping at the end
+    // memmove copes with the source and destination overlapping so there is no need for a temporary copy
     insertion = m_random->RandomInt(0, genomeLength - 1);
-    for (i = 0; i < length; i++)
-    {
-        genome->SetGene(insertion, store[i]);
-        insertion++;
-        if (insertion >= genomeLength) break;
-    }
+    size_t copied = size_t(std::max(0, std::min(length, genomeLength - insertion)));
+    std::memmove(genes + insertion, genes + origin, copied * sizeof(double));
+    if (clampToBounds) ClampToBounds(genes, schema, size_t(insertion), size_t(insertion) + copied);
 
     return 1;
 }
 
+// fill the batch with count offspring bred from the parents population
+// this makes the same random choices in the same order as breeding the offspring one at a time
+// an offspring that ends up unchanged is bred again from newly chosen parents
+void Mating::BreedBatch(Population *parents, const OffspringSettings &settings, size_t count, OffspringBatch *batch)
+{
+    size_t genomeLength = parents->GetGenomeLength();
+    batch->Reset(genomeLength, count);
+    for (size_t j = 0; j < count; j++)
+    {
+        double *offspring = batch->GetGenes(j);
+        int mutationCount = 0;
+        while (mutationCount == 0) // this means we always get some mutation (no point in getting unmutated offspring)
+        {
+            size_t parent1Rank, parent2Rank = OffspringBatch::kNoParent;
+            const double *parent1 = parents->ChooseParent(&parent1Rank, m_random);
+            if (m_random->CoinFlip(settings.crossoverChance))
+            {
+                const double *parent2 = parents->ChooseParent(&parent2Rank, m_random);
+                mutationCount += Mate(parent1, parent2, offspring, genomeLength, settings.crossoverType);
+            }
+            else
+            {
+                std::memcpy(offspring, parent1, genomeLength * sizeof(double));
+            }
+            const std::shared_ptr<const GenomeSchema> &schema = parents->GetSchema(parent1Rank);
+            if (settings.multipleGaussian && settings.geometricSkipMutation) mutationCount += GeometricSkipGaussianMutate(offspring, *schema, settings.gaussianMutationChance, settings.bounceMutation);
+            else if (settings.multipleGaussian) mutationCount += MultipleGaussianMutate(offspring, *schema, settings.gaussianMutationChance, settings.bounceMutation);
+            else mutationCount += GaussianMutate(offspring, *schema, settings.gaussianMutationChance, settings.bounceMutation);
+
+            mutationCount += FrameShiftMutate(offspring, *schema, settings.frameShiftMutationChance, settings.clampShiftedGenes);
+            mutationCount += DuplicationMutate(offspring, *schema, settings.duplicationMutationChance, settings.clampShiftedGenes);
+
+            batch->SetParents(j, parent1Rank, parent2Rank);
+            batch->SetSchema(j, schema);
+        }
+        batch->SetMutationCount(j, mutationCount);
+    }
+}
+
 void Mating::SetRandom(Random *random)
 {
     m_random = random;
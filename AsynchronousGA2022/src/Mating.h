@@ -10,9 +10,15 @@
 #ifndef MATING_H
 #define MATING_H
 
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
 class Genome;
+class GenomeSchema;
 class Population;
 class Random;
+class OffspringBatch;
 
 class Mating
 {
@@ -25,15 +31,46 @@ public:
         Average = 1
     };
 
+    // the choices that control how offspring are bred (these come from the Preferences)
+    struct OffspringSettings
+    {
+        double crossoverChance = 0;
+        CrossoverType crossoverType = Average;
+        double gaussianMutationChance = 0;
+        bool multipleGaussian = false;
+        bool geometricSkipMutation = false;
+        bool bounceMutation = true;
+        double frameShiftMutationChance = 0;
+        double duplicationMutationChance = 0;
+        bool clampShiftedGenes = false;
+    };
+
     void SetRandom(Random *random);
-    int Mate(Genome *parent1, Genome *parent2, Genome *offspring, CrossoverType type);
+    int Mate(const double *parent1, const double *parent2, Genome *offspring, CrossoverType type);
     int GaussianMutate(Genome *genome, double mutationChance, bool bounceMutation);
     int MultipleGaussianMutate(Genome *genome, double mutationChance, bool bounceMutation);
-    int FrameShiftMutate(Genome *genome, double mutationChance);
-    int DuplicationMutate(Genome *genome, double mutationChance);
+    int GeometricSkipGaussianMutate(Genome *genome, double mutationChance, bool bounceMutation);
+    int FrameShiftMutate(Genome *genome, double mutationChance, bool clampToBounds = false);
+    int DuplicationMutate(Genome *genome, double mutationChance, bool clampToBounds = false);
+
+    // these work directly on a row of genes
+    int Mate(const double *parent1, const double *parent2, double *offspring, size_t genomeLength, CrossoverType type);
+    int GaussianMutate(double *genes, const GenomeSchema &schema, double mutationChance, bool bounceMutation);
+    int MultipleGaussianMutate(double *genes, const GenomeSchema &schema, double mutationChance, bool bounceMutation);
+    int GeometricSkipGaussianMutate(double *genes, const GenomeSchema &schema, double mutationChance, bool bounceMutation);
+    int FrameShiftMutate(double *genes, const GenomeSchema &schema, double mutationChance, bool clampToBounds);
+    int DuplicationMutate(double *genes, const GenomeSchema &schema, double mutationChance, bool clampToBounds);
+
+    void BreedBatch(Population *parents, const OffspringSettings &settings, size_t count, OffspringBatch *batch);
 
 private:
     Random *m_random = nullptr;
+
+    // scratch space reused between calls
+    std::vector<double> m_uniforms;
+    std::vector<double> m_gaussians;
+    std::vector<double> m_deltas;
+    std::vector<uint32_t> m_mutatedGenes;
 };
 
 
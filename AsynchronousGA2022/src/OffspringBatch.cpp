@@ -0,0 +1,68 @@
+/*
+ *  OffspringBatch.cpp
+ *  AsynchronousGA
+ *
+ *  Created by Bill Sellers on 19/10/2026.
+ *  Copyright 2026 Bill Sellers. All rights reserved.
+ *
+ */
+
+#include "OffspringBatch.h"
+#include "Genome.h"
+
+OffspringBatch::OffspringBatch()
+{
+}
+
+// make room for count offspring of genomeLength genes
+// anything already in the batch is discarded
+void OffspringBatch::Reset(size_t genomeLength, size_t count)
+{
+    if (m_Arena.GetGenomeLength() != genomeLength || m_Arena.GetStride() == 0) m_Arena.Initialise(genomeLength, count);
+    m_Arena.Clear();
+    m_Arena.Reserve(count);
+    for (size_t i = 0; i < count; i++) m_Arena.Allocate(); // slots are handed out in order so slot i is row i
+    m_Parent1Ranks.resize(count);
+    m_Parent2Ranks.resize(count);
+    m_MutationCounts.resize(count);
+    m_Schemas.resize(count);
+    m_Rejected.assign(count, 0);
+    m_Size = count;
+    m_Next = 0;
+    m_RejectedRemaining = 0;
+}
+
+// discard any offspring that have not been taken
+// the storage is kept for the next batch
+void OffspringBatch::Clear()
+{
+    m_Size = 0;
+    m_Next = 0;
+    m_RejectedRemaining = 0;
+}
+
+// copy the next offspring into genome
+// returns false if the batch is empty
+bool OffspringBatch::TakeNext(Genome *genome)
+{
+    while (m_Next < m_Size && m_Rejected[m_Next])
+    {
+        m_Next++;
+        m_RejectedRemaining--;
+    }
+    if (m_Next >= m_Size) return false;
+    const double *genes = m_Arena.GetGenes(m_Next);
+    genome->GetGenes()->assign(genes, genes + m_Arena.GetGenomeLength());
+    genome->SetSchema(m_Schemas[m_Next]);
+    genome->SetFitness(-std::numeric_limits<double>::max());
+    m_Next++;
+    return true;
+}
+
+// the offspring will not be handed out by TakeNext
+void OffspringBatch::Reject(size_t i)
+{
+    if (i < m_Next || i >= m_Size || m_Rejected[i]) return;
+    m_Rejected[i] = 1;
+    m_RejectedRemaining++;
+}
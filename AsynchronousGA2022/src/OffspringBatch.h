@@ -0,0 +1,66 @@
+/*
+ *  OffspringBatch.h
+ *  AsynchronousGA
+ *
+ *  Created by Bill Sellers on 19/10/2026.
+ *  Copyright 2026 Bill Sellers. All rights reserved.
+ *
+ */
+
+#ifndef OFFSPRINGBATCH_H
+#define OFFSPRINGBATCH_H
+
+#include "GeneArena.h"
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+class Genome;
+class GenomeSchema;
+
+// A block of offspring produced by Mating::BreedBatch. The genes of each offspring are a
+// row of a GeneArena and everything else about the offspring is held in parallel arrays.
+// The storage is kept between batches so refilling a batch does not allocate anything.
+// The offspring are handed out in order with TakeNext, skipping any that have been rejected.
+class OffspringBatch
+{
+public:
+    OffspringBatch();
+
+    void Reset(size_t genomeLength, size_t count);
+    void Clear();
+
+    bool TakeNext(Genome *genome);
+    void Reject(size_t i);
+
+    size_t GetSize() const { return m_Size; }
+    size_t GetRemaining() const { return m_Size - m_Next - m_RejectedRemaining; }
+    size_t GetGenomeLength() const { return m_Arena.GetGenomeLength(); }
+
+    double *GetGenes(size_t i) { return m_Arena.GetGenes(i); }
+    const double *GetGenes(size_t i) const { return m_Arena.GetGenes(i); }
+    size_t GetParent1Rank(size_t i) const { return m_Parent1Ranks[i]; }
+    size_t GetParent2Rank(size_t i) const { return m_Parent2Ranks[i]; }
+    int GetMutationCount(size_t i) const { return m_MutationCounts[i]; }
+    const std::shared_ptr<const GenomeSchema> &GetSchema(size_t i) const { return m_Schemas[i]; }
+
+    void SetParents(size_t i, size_t parent1Rank, size_t parent2Rank) { m_Parent1Ranks[i] = parent1Rank; m_Parent2Ranks[i] = parent2Rank; }
+    void SetMutationCount(size_t i, int mutationCount) { m_MutationCounts[i] = mutationCount; }
+    void SetSchema(size_t i, const std::shared_ptr<const GenomeSchema> &schema) { m_Schemas[i] = schema; }
+
+    static const size_t kNoParent = size_t(-1); // parent 2 when there was no crossover
+
+private:
+    GeneArena m_Arena;
+    std::vector<size_t> m_Parent1Ranks;
+    std::vector<size_t> m_Parent2Ranks;
+    std::vector<int> m_MutationCounts;
+    std::vector<std::shared_ptr<const GenomeSchema>> m_Schemas;
+    std::vector<char> m_Rejected;
+    size_t m_Size = 0;
+    size_t m_Next = 0;
+    size_t m_RejectedRemaining = 0; // rejected offspring that have not been skipped yet
+};
+
+#endif // OFFSPRINGBATCH_H
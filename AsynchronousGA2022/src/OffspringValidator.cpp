@@ -0,0 +1,60 @@
+/*
+ *  OffspringValidator.cpp
+ *  AsynchronousGA
+ *
+ *  Created by Bill Sellers on 19/10/2026.
+ *  Copyright 2026 Bill Sellers. All rights reserved.
+ *
+ */
+
+#include "OffspringValidator.h"
+#include "OffspringBatch.h"
+
+#include <cstring>
+#include <cstdint>
+
+namespace
+{
+
+// checked on the bits because -ffast-math lets the compiler assume std::isfinite is always true
+bool IsFinite(double value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x7ff0000000000000ull) != 0x7ff0000000000000ull;
+}
+
+}
+
+OffspringValidator::OffspringValidator()
+{
+}
+
+// returns 0 on success
+int OffspringValidator::Initialise(const char *baseXML, size_t length)
+{
+    if (m_XMLConverter.LoadBaseXMLString(baseXML, length)) return __LINE__;
+    return 0;
+}
+
+void OffspringValidator::Validate(const OffspringBatch &batch, std::vector<char> *valid)
+{
+    size_t genomeLength = batch.GetGenomeLength();
+    size_t count = batch.GetSize();
+    size_t numValues = m_XMLConverter.GetNumSubstitutions();
+    m_Genes.resize(genomeLength * count);
+    for (size_t i = 0; i < count; i++)
+    {
+        const double *genes = batch.GetGenes(i);
+        for (size_t locus = 0; locus < genomeLength; locus++) m_Genes[locus * count + i] = genes[locus];
+    }
+    m_Values.resize(numValues * count);
+    if (count) m_XMLConverter.ApplyGenomes(int(genomeLength), count, m_Genes.data(), count, m_Values.data(), count);
+    valid->assign(count, 1);
+    for (size_t j = 0; j < numValues; j++)
+    {
+        const double *values = m_Values.data() + j * count;
+        for (size_t i = 0; i < count; i++)
+            if (!IsFinite(values[i])) (*valid)[i] = 0;
+    }
+}
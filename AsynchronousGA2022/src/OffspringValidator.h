@@ -0,0 +1,42 @@
+/*
+ *  OffspringValidator.h
+ *  AsynchronousGA
+ *
+ *  Created by Bill Sellers on 19/10/2026.
+ *  Copyright 2026 Bill Sellers. All rights reserved.
+ *
+ */
+
+#ifndef OFFSPRINGVALIDATOR_H
+#define OFFSPRINGVALIDATOR_H
+
+#include "XMLConverter.h"
+
+#include <vector>
+#include <cstddef>
+
+class OffspringBatch;
+
+// Checks a batch of offspring against the base XML before they are sent.
+// Every substitution is evaluated for every offspring with XMLConverter::ApplyGenomes and an
+// offspring is rejected if any of its values is nan or inf, since the client would only find
+// that out after loading the model and running it.
+// The check runs on the calling thread as soon as a batch is bred. Every score changes the
+// population the next batch is bred from so there is no later batch it could overlap with.
+class OffspringValidator
+{
+public:
+    OffspringValidator();
+
+    int Initialise(const char *baseXML, size_t length);
+
+    // valid[i] is set to 0 for each offspring that should not be sent
+    void Validate(const OffspringBatch &batch, std::vector<char> *valid);
+
+private:
+    XMLConverter m_XMLConverter;
+    std::vector<double> m_Genes; // the batch genes in structure of arrays form
+    std::vector<double> m_Values;
+};
+
+#endif // OFFSPRINGVALIDATOR_H
@@ -0,0 +1,316 @@
+/*
+ *  OrderStatisticTree.h
+ *  AsynchronousGA
+ *
+ *  Created by Bill Sellers on 19/10/2026.
+ *  Copyright 2026 Bill Sellers. All rights reserved.
+ *
+ */
+
+#ifndef ORDERSTATISTICTREE_H
+#define ORDERSTATISTICTREE_H
+
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+
+// A treap where every node also stores the size of its subtree so that as well as
+// O(log n) insert, erase and find it can select the nth smallest key in O(log n).
+// The nodes live in a pooled vector and refer to each other by index so erased nodes
+// are reused rather than freed. Pointers to the values are only valid until the next
+// insertion that has to grow the pool (use Reserve to avoid this).
+template <typename Key, typename Value, typename Compare = std::less<Key>>
+class OrderStatisticTree
+{
+public:
+    OrderStatisticTree() {}
+
+    // returns false (and leaves value untouched) if the key is already present
+    bool Insert(const Key &key, Value &&value)
+    {
+        bool inserted = false;
+        m_root = InsertNode(m_root, key, value, &inserted);
+        return inserted;
+    }
+
+    // returns false if the key is not present
+    // if erasedValue is set then the erased value is moved into it
+    bool Erase(const Key &key, Value *erasedValue = nullptr)
+    {
+        bool erased = false;
+        m_root = EraseNode(m_root, key, erasedValue, &erased);
+        return erased;
+    }
+
+    Value *Find(const Key &key)
+    {
+        size_t t = m_root;
+        while (t != kNull)
+        {
+            if (m_compare(key, m_nodes[t].key)) t = m_nodes[t].left;
+            else if (m_compare(m_nodes[t].key, key)) t = m_nodes[t].right;
+            else return &m_nodes[t].value;
+        }
+        return nullptr;
+    }
+
+    // rank 0 is the smallest key
+    Value &Select(size_t rank) { return m_nodes[SelectNode(rank)].value; }
+    const Key &SelectKey(size_t rank) const { return m_nodes[SelectNode(rank)].key; }
+
+    // the number of keys that are less than key
+    size_t Rank(const Key &key) const
+    {
+        size_t rank = 0;
+        size_t t = m_root;
+        while (t != kNull)
+        {
+            if (m_compare(m_nodes[t].key, key))
+            {
+                rank += Size(m_nodes[t].left) + 1;
+                t = m_nodes[t].right;
+            }
+            else t = m_nodes[t].left;
+        }
+        return rank;
+    }
+
+    Value &Front() { return m_nodes[FrontNode()].value; }
+    Value &Back() { return m_nodes[BackNode()].value; }
+    const Key &FrontKey() const { return m_nodes[FrontNode()].key; }
+    const Key &BackKey() const { return m_nodes[BackNode()].key; }
+
+    size_t Size() const { return Size(m_root); }
+
+    void Clear()
+    {
+        m_nodes.clear();
+        m_free.clear();
+        m_root = kNull;
+    }
+
+    void Reserve(size_t n) { m_nodes.reserve(n); }
+
+    // replace the contents in O(n) from keys that are already sorted and unique
+    // the tree is perfectly balanced and the priorities are random numbers handed out
+    // largest first in breadth first order so later insertions behave normally
+    void BuildFromSorted(std::vector<std::pair<Key, Value>> &&entries)
+    {
+        Clear();
+        size_t n = entries.size();
+        if (n == 0) return;
+        std::vector<uint64_t> priorities(n);
+        for (auto &&it : priorities) it = NextPriority();
+        std::sort(priorities.begin(), priorities.end(), std::greater<uint64_t>());
+        m_nodes.resize(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            m_nodes[i].key = std::move(entries[i].first);
+            m_nodes[i].value = std::move(entries[i].second);
+        }
+        // each queue entry is a half open range of the sorted entries and the node at its middle is the root of that range
+        std::vector<std::pair<size_t, size_t>> queue;
+        queue.reserve(n);
+        queue.push_back(std::make_pair(size_t(0), n));
+        for (size_t next = 0; next < queue.size(); next++)
+        {
+            size_t low = queue[next].first;
+            size_t high = queue[next].second;
+            size_t t = low + (high - low) / 2;
+            m_nodes[t].priority = priorities[next];
+            m_nodes[t].size = high - low;
+            m_nodes[t].left = kNull;
+            m_nodes[t].right = kNull;
+            if (low < t)
+            {
+                m_nodes[t].left = low + (t - low) / 2;
+                queue.push_back(std::make_pair(low, t));
+            }
+            if (t + 1 < high)
+            {
+                m_nodes[t].right = t + 1 + (high - t - 1) / 2;
+                queue.push_back(std::make_pair(t + 1, high));
+            }
+        }
+        m_root = n / 2;
+    }
+
+    // visit every entry in ascending key order as function(const Key &, Value &)
+    template <typename Function> void ForEach(Function function) { ForEachNode(m_root, function); }
+
+private:
+    static const size_t kNull = size_t(-1);
+
+    struct Node
+    {
+        Key key;
+        Value value;
+        size_t left;
+        size_t right;
+        size_t size;
+        uint64_t priority;
+    };
+
+    size_t Size(size_t t) const { return t == kNull ? 0 : m_nodes[t].size; }
+    void Update(size_t t) { m_nodes[t].size = 1 + Size(m_nodes[t].left) + Size(m_nodes[t].right); }
+
+    uint64_t NextPriority()
+    {
+        // xorshift64* is plenty for balancing and keeps the tree shape reproducible
+        m_priorityState ^= m_priorityState >> 12;
+        m_priorityState ^= m_priorityState << 25;
+        m_priorityState ^= m_priorityState >> 27;
+        return m_priorityState * 0x2545F4914F6CDD1DULL;
+    }
+
+    size_t AllocateNode(const Key &key, Value &value)
+    {
+        size_t t;
+        if (m_free.size())
+        {
+            t = m_free.back();
+            m_free.pop_back();
+        }
+        else
+        {
+            t = m_nodes.size();
+            m_nodes.emplace_back();
+        }
+        Node &node = m_nodes[t];
+        node.key = key;
+        node.value = std::move(value);
+        node.left = kNull;
+        node.right = kNull;
+        node.size = 1;
+        node.priority = NextPriority();
+        return t;
+    }
+
+    size_t RotateRight(size_t t)
+    {
+        size_t l = m_nodes[t].left;
+        m_nodes[t].left = m_nodes[l].right;
+        m_nodes[l].right = t;
+        Update(t);
+        Update(l);
+        return l;
+    }
+
+    size_t RotateLeft(size_t t)
+    {
+        size_t r = m_nodes[t].right;
+        m_nodes[t].right = m_nodes[r].left;
+        m_nodes[r].left = t;
+        Update(t);
+        Update(r);
+        return r;
+    }
+
+    // note: the pool can grow inside this call so no references into m_nodes are held across the recursion
+    size_t InsertNode(size_t t, const Key &key, Value &value, bool *inserted)
+    {
+        if (t == kNull)
+        {
+            *inserted = true;
+            return AllocateNode(key, value);
+        }
+        if (m_compare(key, m_nodes[t].key))
+        {
+            size_t child = InsertNode(m_nodes[t].left, key, value, inserted);
+            m_nodes[t].left = child;
+            if (m_nodes[child].priority > m_nodes[t].priority) return RotateRight(t);
+        }
+        else if (m_compare(m_nodes[t].key, key))
+        {
+            size_t child = InsertNode(m_nodes[t].right, key, value, inserted);
+            m_nodes[t].right = child;
+            if (m_nodes[child].priority > m_nodes[t].priority) return RotateLeft(t);
+        }
+        else return t;
+        Update(t);
+        return t;
+    }
+
+    size_t EraseNode(size_t t, const Key &key, Value *erasedValue, bool *erased)
+    {
+        if (t == kNull) return kNull;
+        if (m_compare(key, m_nodes[t].key)) m_nodes[t].left = EraseNode(m_nodes[t].left, key, erasedValue, erased);
+        else if (m_compare(m_nodes[t].key, key)) m_nodes[t].right = EraseNode(m_nodes[t].right, key, erasedValue, erased);
+        else
+        {
+            *erased = true;
+            if (erasedValue) *erasedValue = std::move(m_nodes[t].value);
+            size_t merged = Merge(m_nodes[t].left, m_nodes[t].right);
+            m_free.push_back(t);
+            return merged;
+        }
+        Update(t);
+        return t;
+    }
+
+    // all the keys in a must be less than all the keys in b
+    size_t Merge(size_t a, size_t b)
+    {
+        if (a == kNull) return b;
+        if (b == kNull) return a;
+        if (m_nodes[a].priority > m_nodes[b].priority)
+        {
+            m_nodes[a].right = Merge(m_nodes[a].right, b);
+            Update(a);
+            return a;
+        }
+        m_nodes[b].left = Merge(a, m_nodes[b].left);
+        Update(b);
+        return b;
+    }
+
+    size_t SelectNode(size_t rank) const
+    {
+        size_t t = m_root;
+        while (t != kNull)
+        {
+            size_t leftSize = Size(m_nodes[t].left);
+            if (rank < leftSize) t = m_nodes[t].left;
+            else if (rank == leftSize) return t;
+            else
+            {
+                rank -= leftSize + 1;
+                t = m_nodes[t].right;
+            }
+        }
+        return kNull; // rank out of range
+    }
+
+    size_t FrontNode() const
+    {
+        size_t t = m_root;
+        while (t != kNull && m_nodes[t].left != kNull) t = m_nodes[t].left;
+        return t;
+    }
+
+    size_t BackNode() const
+    {
+        size_t t = m_root;
+        while (t != kNull && m_nodes[t].right != kNull) t = m_nodes[t].right;
+        return t;
+    }
+
+    template <typename Function> void ForEachNode(size_t t, Function &function)
+    {
+        if (t == kNull) return;
+        ForEachNode(m_nodes[t].left, function);
+        function(static_cast<const Key &>(m_nodes[t].key), m_nodes[t].value);
+        ForEachNode(m_nodes[t].right, function);
+    }
+
+    std::vector<Node> m_nodes;
+    std::vector<size_t> m_free;
+    size_t m_root = kNull;
+    uint64_t m_priorityState = 0x9E3779B97F4A7C15ULL;
+    Compare m_compare;
+};
+
+#endif // ORDERSTATISTICTREE_H
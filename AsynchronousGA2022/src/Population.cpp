@@ -12,16 +12,22 @@
 #include <fstream>
 #include <memory.h>
 #include <float.h>
-#include <map>
 #include <list>
 #include <cmath>
 #include <limits>
 #include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <cstdlib>
+#include <thread>
+#include <atomic>
 
 #include "Genome.h"
 #include "Population.h"
 #include "Random.h"
 #include "Preferences.h"
+#include "MappedFile.h"
+#include "GenomeWriter.h"
 
 bool GenomeFitnessLessThan(Genome *g1, Genome *g2);
 
@@ -34,81 +40,124 @@ Population::Population()
 // initialise the population
 void Population::InitialisePopulation(size_t populationSize, const Genome &genome)
 {
-    m_Population.clear();
-    m_PopulationIndex.resize(populationSize);
+    m_Population.Clear();
+    m_Stats.Clear();
+    m_Population.Reserve(populationSize + 1);
+    m_Arena.Initialise(genome.GetGenomeLength(), populationSize + 1);
+    m_TargetPopulationSize = populationSize;
+    Genome g = genome;
     for (size_t i = 0; i < populationSize; i++)
     {
-        m_Population[double(i)] = genome;
-        m_PopulationIndex[i] = double(i);
+        g.SetFitness(double(i));
+        AddToPopulation(g);
     }
 }
 
-// choose a parent from a population
-Genome *Population::ChooseParent(size_t *parentRank, Random *random)
+// put a copy of a genome into the arena and the sorted tree
+// every genome gets a new sequence number so the key is always unique
+PopulationKey Population::AddToPopulation(const Genome &genome)
 {
-    // this type biases random choice to higher ranked individuals using the gamma function
-    // this assumes a sorted genome
-    if (m_SelectionType == GammaBasedSelection)
-    {
-        *parentRank = random->GammaBiasedRandomInt(0, m_Population.size() - 1, m_Gamma);
-        return &m_Population[m_PopulationIndex[*parentRank]];
-    }
+    if (m_Population.Size() == 0 && m_Arena.GetGenomeLength() != genome.GetGenomeLength())
+        m_Arena.Initialise(genome.GetGenomeLength(), m_Arena.GetCapacity());
+    size_t slot = m_Arena.Allocate();
+    PopulationKey key = {genome.GetFitness(), m_NextSequence++};
+    m_Population.Insert(key, std::move(slot));
+    if (m_Schemas.size() < m_Arena.GetCapacity()) m_Schemas.resize(m_Arena.GetCapacity());
+    std::copy_n(genome.GetGenes()->data(), genome.GetGenomeLength(), m_Arena.GetGenes(slot));
+    m_Arena.SetFitness(slot, genome.GetFitness());
+    m_Schemas[slot] = genome.GetSchema();
+    m_Stats.Add(genome.GetFitness());
+    return key;
+}
 
-    // in this version we do uniform selection and just choose a parent
-    // at random
-    if (m_SelectionType == UniformSelection)
-    {
-        *parentRank = random->RandomInt(0, m_Population.size() - 1);
-        return &m_Population[m_PopulationIndex[*parentRank]];
-    }
+bool Population::RemoveFromPopulation(const PopulationKey &key)
+{
+    size_t slot;
+    if (!m_Population.Erase(key, &slot)) return false;
+    m_Stats.Remove(m_Arena.GetFitness(slot));
+    m_Arena.Free(slot); // the slot gets reused by the next insertion
+    return true;
+}
 
-    // this type biases random choice to higher ranked individuals
-    // this assumes a sorted genome
-    if (m_SelectionType == RankBasedSelection)
+// the running statistics are recalculated if they have stopped being usable
+const PopulationStats *Population::GetPopulationStats()
+{
+    if (!m_Stats.IsValid())
     {
-        *parentRank = random->RankBiasedRandomInt(1, m_Population.size()) - 1;
-        return &m_Population[m_PopulationIndex[*parentRank]];
+        m_Stats.Clear();
+        m_Population.ForEach([this](const PopulationKey &, size_t &slot) { m_Stats.Add(m_Arena.GetFitness(slot)); });
     }
+    return &m_Stats;
+}
 
-    // this type biases random choice to higher ranked individuals
-    // this assumes a sorted genome
-    if (m_SelectionType == SqrtBasedSelection)
-    {
-        *parentRank = random->SqrtBiasedRandomInt(0, m_Population.size() - 1);
-        return &m_Population[m_PopulationIndex[*parentRank]];
-    }
+// copy a genome out of the arena (this reuses the storage in genome if possible)
+void Population::CopyGenome(size_t slot, Genome *genome)
+{
+    const double *genes = m_Arena.GetGenes(slot);
+    genome->GetGenes()->assign(genes, genes + m_Arena.GetGenomeLength());
+    genome->SetSchema(m_Schemas[slot]);
+    genome->SetFitness(m_Arena.GetFitness(slot));
+}
 
-    // should never get here
-    std::cerr << "Logic error Population::ChooseParent " << __LINE__ << "\n";
-    return 0;
+// choose a parent from a population
+// the biased selection types choose higher ranked individuals more often
+const double *Population::ChooseParent(size_t *parentRank, Random *random)
+{
+    size_t size = m_Population.Size();
+    // the alias table is only worth building once the population has stopped growing
+    if (size == m_TargetPopulationSize && !m_Sampler.IsBuilt(m_SelectionType, size, m_Gamma))
+        m_Sampler.Build(m_SelectionType, size, m_Gamma);
+    *parentRank = m_Sampler.Draw(m_SelectionType, size, m_Gamma, random);
+    return m_Arena.GetGenes(m_Population.Select(*parentRank));
 }
 
 // insert a genome into the population
 // the population is always kept sorted by fitness
 // the oldest genome is deleted unless it is in the
 // immortal list
-// the key is the numeric value of the fitness so there are rare cases when
-// different genomes with the same fitness will not be accepted
-int Population::InsertGenome(Genome &&genome, size_t targetPopulationSize)
+// genomes with the same fitness are ordered by when they were inserted
+int Population::InsertGenome(const Genome &genome, size_t targetPopulationSize)
 {
-    size_t originalSize = m_Population.size();
+    size_t originalSize = m_Population.Size();
     if (targetPopulationSize == 0) targetPopulationSize = originalSize; // not trying to change the size of the population
+    m_TargetPopulationSize = targetPopulationSize;
 
-    double fitness = genome.GetFitness();
-    auto findGenome = m_Population.find(fitness);
-    if (findGenome != m_Population.end())
+    if (originalSize && genome.GetGenomeLength() != m_Arena.GetGenomeLength())
     {
-        // std::cerr << "InsertGenome fitness = " << fitness << " already in population\n";
-        return __LINE__; // nothing inserted because the fitness already exists
+        std::cerr << "Error Population::InsertGenome genome length " << genome.GetGenomeLength() << " does not match population genome length " << m_Arena.GetGenomeLength() << "\n";
+        return __LINE__;
     }
-    m_Population[fitness] = genome;
+    m_Population.Reserve(targetPopulationSize + 1);
+    m_Arena.Reserve(targetPopulationSize + 1); // keeps the gene pointers stable once the population is full
+    PopulationKey key = AddToPopulation(genome);
+    AddToAgeLists(key);
 
-    // ok now insert into the other internal lists
-    m_PopulationIndex.insert(std::upper_bound(m_PopulationIndex.begin(), m_PopulationIndex.end(), fitness), fitness); // insert at upper bound to minimise shifting
+    // check population sizes
+    while (m_Population.Size() > targetPopulationSize)
+    {
+        if (m_AgeList.size() == 0)
+        {
+            std::cerr << "Logic error Population::InsertGenome m_ageList has zero size " << __LINE__ << "\n";
+            RemoveFromPopulation(m_Population.FrontKey());
+            continue;
+        }
+        PopulationKey genomeToDelete = *m_AgeList.begin();
+        m_AgeList.pop_front();
+        if (!RemoveFromPopulation(genomeToDelete))
+        {
+            std::cerr << "Logic error Population::InsertGenome genome not found in m_Population " << __LINE__ << "\n";
+            RemoveFromPopulation(m_Population.FrontKey());
+        }
+    }
+    return 0;
+}
 
+// put a newly inserted genome into either the age list or the immortal list
+void Population::AddToAgeLists(const PopulationKey &key)
+{
     if (m_ParentsToKeep == 0)
     {
-        m_AgeList.push_back(fitness); // just add current genome to list by age
+        m_AgeList.push_back(key); // just add current genome to list by age
         // std::cerr << "InsertGenome adding to m_AgeList - no test; size = " << m_AgeList.size() << "\n";
     }
     else
@@ -116,103 +165,74 @@ int Population::InsertGenome(Genome &&genome, size_t targetPopulationSize)
         // need to worry about immortality
         if (m_ImmortalListIndex.size() < m_ParentsToKeep)
         {
-            m_ImmortalListIndex.insert(std::upper_bound(m_ImmortalListIndex.begin(), m_ImmortalListIndex.end(), fitness), fitness);
+            m_ImmortalListIndex.insert(std::upper_bound(m_ImmortalListIndex.begin(), m_ImmortalListIndex.end(), key), key);
             // std::cerr << "InsertGenome adding to m_ImmortalList - no test; size = " << m_ImmortalList.size() << "\n";
         }
         else
         {
-            if (fitness > m_ImmortalListIndex[0])
+            if (key.fitness > m_ImmortalListIndex[0].fitness) // a tie does not displace an existing immortal
             {
-                m_ImmortalListIndex.insert(std::upper_bound(m_ImmortalListIndex.begin(), m_ImmortalListIndex.end(), fitness), fitness);
+                m_ImmortalListIndex.insert(std::upper_bound(m_ImmortalListIndex.begin(), m_ImmortalListIndex.end(), key), key);
                 m_AgeList.push_back(m_ImmortalListIndex.front());
                 m_ImmortalListIndex.erase(m_ImmortalListIndex.begin());
                 // std::cerr << "InsertGenome m_ImmortalList to m_AgeList bump; m_AgeList.size() = " << m_AgeList.size() << " m_ImmortalList.size() = " << m_ImmortalList.size() << "\n";
             }
             else
             {
-                m_AgeList.push_back(fitness);
+                m_AgeList.push_back(key);
                 // std::cerr << "InsertGenome adding to m_AgeList after test; size = " << m_AgeList.size() << "\n";
             }
         }
     }
-
-    // check population sizes
-    while (m_Population.size() > targetPopulationSize)
-    {
-        if (m_AgeList.size() == 0)
-        {
-            std::cerr << "Logic error Population::InsertGenome m_ageList has zero size " << __LINE__ << "\n";
-            m_Population.erase(*m_PopulationIndex.begin());
-            m_PopulationIndex.erase(m_PopulationIndex.begin());
-            continue;
-        }
-        double genomeToDelete = *m_AgeList.begin();
-        m_AgeList.pop_front();
-        auto genomeIt = m_Population.find(genomeToDelete);
-        if (genomeIt != m_Population.end())
-        {
-            m_Population.erase(genomeIt);
-        }
-        else
-        {
-            std::cerr << "Logic error Population::InsertGenome genome not found in m_Population " << __LINE__ << "\n";
-            m_Population.erase(m_Population.begin());
-            m_PopulationIndex.erase(m_PopulationIndex.begin());
-            continue;
-        }
-        auto fitnessIt = std::lower_bound(m_PopulationIndex.begin(), m_PopulationIndex.end(), genomeToDelete); // delete at lower bound because this value matches (whereas upper bound does not)
-        if (fitnessIt != m_PopulationIndex.end() && *fitnessIt == genomeToDelete)
-        {
-            m_PopulationIndex.erase(fitnessIt);
-        }
-        else
-        {
-            std::cerr << "Logic error Population::InsertGenome genome not found in m_PopulationIndex " << __LINE__ << "\n";
-            m_PopulationIndex.clear(); // need to rebuild the index by getting all the indexes and sorting (quicker than inserting at a sorted location each time)
-            for (auto &&it : m_Population) { m_PopulationIndex.push_back(it.first); }
-            std::sort(m_PopulationIndex.begin(), m_PopulationIndex.end());
-        }
-    }
-    return 0;
 }
 
 // randomise the population
 void Population::Randomise(Random *random)
 {
-    for (auto iter = m_Population.begin(); iter != m_Population.end(); iter++)
-        iter->second.Randomise(random);
+    size_t genomeLength = m_Arena.GetGenomeLength();
+    m_Population.ForEach([&](const PopulationKey &, size_t &slot)
+    {
+        // this matches Genome::Randomise
+        const GenomeSchema *schema = m_Schemas[slot].get();
+        double *genes = m_Arena.GetGenes(slot);
+        for (size_t i = 0; i < genomeLength; i++)
+        {
+            if (schema->GetGaussianSD(i) != 0)
+                genes[i] = random->RandomDouble(schema->GetLowBound(i), schema->GetHighBound(i));
+        }
+    });
 }
 
 // reset the population size to a new value - needs at least one valid genome in population
 void Population::ResizePopulation(size_t size, Random *random)
 {
-    if (m_Population.size() == size) return;
-    if (size > m_Population.size())
+    m_TargetPopulationSize = size;
+    if (m_Population.Size() == size) return;
+    if (size > m_Population.Size())
     {
+        m_Population.Reserve(size + 1);
+        m_Arena.Reserve(size + 1);
+        Genome g;
         switch (m_ResizeControl)
         {
         case RandomiseResize:
             // fill in with random genomes
-            for (size_t i = m_Population.size(); i < size; i++)
+            for (size_t i = m_Population.Size(); i < size; i++)
             {
-                Genome g = m_Population.begin()->second;
+                GetFirstGenome(&g); // the new genome keeps the fitness of the one it came from
                 g.Randomise(random);
-                g.SetFitness(std::nextafter(m_PopulationIndex.back(), std::numeric_limits<double>::max()));
-                m_PopulationIndex.push_back(g.GetFitness());
-                m_Population[g.GetFitness()] = std::move(g);
+                AddToPopulation(g);
             }
             break;
 
         case MutateResize:
             // fill in with mutated genomes
-            for (size_t i = m_Population.size(); i < size; i++)
+            for (size_t i = m_Population.Size(); i < size; i++)
             {
-                Genome g = m_Population.begin()->second;
+                GetFirstGenome(&g);
                 Mating mating(random);
                 while (mating.GaussianMutate(&g, 1.0, true) == 0);
-                g.SetFitness(std::nextafter(m_PopulationIndex.back(), std::numeric_limits<double>::max()));
-                m_PopulationIndex.push_back(g.GetFitness());
-                m_Population[g.GetFitness()] = std::move(g);
+                AddToPopulation(g);
             }
             break;
 
@@ -220,12 +240,10 @@ void Population::ResizePopulation(size_t size, Random *random)
     }
     else
     {
-        size_t delta = m_Population.size() - size;
+        size_t delta = m_Population.Size() - size;
         for (size_t i = 0; i < delta; i++)
         {
-            double fitness = m_PopulationIndex.front();
-            m_PopulationIndex.erase(m_PopulationIndex.begin());
-            m_Population.erase(fitness);
+            RemoveFromPopulation(m_Population.FrontKey());
         }
     }
 }
@@ -233,29 +251,40 @@ void Population::ResizePopulation(size_t size, Random *random)
 // set the circular flags for the genomes in the population
 void Population::SetGlobalCircularMutation(bool circularMutation)
 {
-    for (auto iter = m_Population.begin(); iter != m_Population.end(); ++iter)
-        iter->second.SetGlobalCircularMutationFlag(circularMutation);
+    // genomes that shared a schema before should still share one afterwards
+    std::shared_ptr<const GenomeSchema> oldSchema, newSchema;
+    m_Population.ForEach([&](const PopulationKey &, size_t &slot)
+    {
+        if (m_Schemas[slot] != oldSchema)
+        {
+            oldSchema = m_Schemas[slot];
+            if (oldSchema->GetGlobalCircularMutationFlag() == circularMutation) newSchema = oldSchema;
+            else newSchema = oldSchema->WithGlobalCircularMutationFlag(circularMutation);
+        }
+        m_Schemas[slot] = newSchema;
+    });
 }
 
 // output a subpopulation as a new population
 // note: outputs population with fittest first
 int Population::WritePopulation(const char *filename, size_t nBest)
 {
-    if (nBest > m_Population.size()) nBest = m_Population.size();
+    if (nBest > m_Population.Size()) nBest = m_Population.Size();
 
     try
     {
         std::ofstream outFile;
         outFile.exceptions (std::ios::failbit|std::ios::badbit);
         outFile.open(filename);
-        outFile << nBest << "\n";
-        size_t count = 0;
-        for (auto iter = m_Population.rbegin(); iter != m_Population.rend(); ++iter)
+        GenomeWriter writer(&outFile);
+        writer.WriteCount(nBest);
+        size_t lastRank = m_Population.Size() - 1;
+        for (size_t i = 0; i < nBest; i++)
         {
-            outFile << iter->second;
-            count++;
-            if (count >= nBest) break;
+            size_t slot = m_Population.Select(lastRank - i);
+            writer.WriteGenome(m_Arena.GetGenes(slot), m_Arena.GetGenomeLength(), m_Arena.GetFitness(slot), m_Schemas[slot]);
         }
+        writer.Flush();
         outFile.close();
     }
     catch (std::exception& e)
@@ -270,39 +299,37 @@ int Population::WritePopulation(const char *filename, size_t nBest)
 }
 
 // read a population
-// this can be quite slow because it re-sorts everything which may not be necessary
-// and it may not preserve existing fitnesses if they are not all unique
+// files in the layout written by WritePopulation are read by ReadPopulationFast
+// and anything else falls back to the stream reader which is much slower
 int Population::ReadPopulation(const char *filename)
 {
+    if (ReadPopulationFast(filename) == 0) return 0;
+
     std::ifstream inFile;
     inFile.exceptions (std::ios::failbit|std::ios::badbit|std::ios::eofbit);
     try
     {
         inFile.open(filename);
 
-        m_Population.clear();
-        m_PopulationIndex.clear();
+        m_Population.Clear();
+        m_Arena.Clear();
+        m_Stats.Clear();
+        m_NextSequence = 0;
         m_ImmortalListIndex.clear();
         m_AgeList.clear();
 
         size_t populationSize;
         inFile >> populationSize;
-        bool warningEmitted = false;
+        std::shared_ptr<const GenomeSchema> sharedSchema;
+        Genome genome;
         for (size_t i = 0; i < populationSize; i++)
         {
-            Genome genome;
             inFile >> genome;
+            // normally all the genomes have the same bounds so they can all use the same schema
+            if (sharedSchema && *sharedSchema == *genome.GetSchema()) genome.SetSchema(sharedSchema);
+            else sharedSchema = genome.GetSchema();
             // std::cerr << "Fitness = " << genome.GetFitness() << "\n";
-            if (i > 0 && m_Population.find(genome.GetFitness()) != m_Population.end())
-            {
-                genome.SetFitness(std::nextafter(m_PopulationIndex.back(), std::numeric_limits<double>::max())); // this line forces all the genomes to be inserted since they might not have valid fitnesses
-                if (!warningEmitted)
-                {
-                    std::cerr << "Warning: population contains duplicate fitness values. Setting to fake values. index first detected = " << i << "\n";
-                    warningEmitted = true;
-                }
-            }
-            InsertGenome(std::move(genome), populationSize);
+            InsertGenome(genome, populationSize);
         }
         inFile.close();
     }
@@ -317,3 +344,218 @@ int Population::ReadPopulation(const char *filename)
     return 0;
 }
 
+// helpers for ReadPopulationFast
+// these only ever skip spaces within a line so that the line structure can be checked
+static const char *SkipBlanks(const char *ptr, const char *end)
+{
+    while (ptr < end && (*ptr == ' ' || *ptr == '\t' || *ptr == '\r' || *ptr == '\v' || *ptr == '\f')) ptr++;
+    return ptr;
+}
+
+static const char *EndOfLine(const char *ptr, const char *end)
+{
+    if (!ptr) return nullptr;
+    ptr = SkipBlanks(ptr, end);
+    if (ptr == end) return ptr;
+    if (*ptr != '\n') return nullptr;
+    return ptr + 1;
+}
+
+template <typename T> static const char *ParseNumber(const char *ptr, const char *end, T *value)
+{
+    if (!ptr) return nullptr;
+    ptr = SkipBlanks(ptr, end);
+    auto result = std::from_chars(ptr, end, *value);
+    if (result.ec != std::errc() || result.ptr == ptr) return nullptr;
+    return result.ptr;
+}
+
+#if !defined(__cpp_lib_to_chars)
+// floating point from_chars is missing from some standard libraries so use strtod
+// which is fine because nothing here changes the C locale
+template <> const char *ParseNumber<double>(const char *ptr, const char *end, double *value)
+{
+    if (!ptr) return nullptr;
+    ptr = SkipBlanks(ptr, end);
+    char buffer[64];
+    size_t length = 0;
+    while (ptr + length < end && length < sizeof(buffer) - 1 && ptr[length] > ' ') { buffer[length] = ptr[length]; length++; }
+    buffer[length] = 0;
+    char *last;
+    *value = std::strtod(buffer, &last);
+    if (last == buffer) return nullptr;
+    return ptr + (last - buffer);
+}
+#endif
+
+// the circular mutation flag is read as a single character in the same way as operator>>
+static const char *ParseFlag(const char *ptr, const char *end, char *value)
+{
+    if (!ptr) return nullptr;
+    ptr = SkipBlanks(ptr, end);
+    if (ptr == end || *ptr == '\n') return nullptr;
+    *value = *ptr;
+    return ptr + 1;
+}
+
+// read a population written by WritePopulation
+// the file is split into chunks that are parsed on separate threads straight into the arena
+// and the tree is then built with a single sort rather than one insertion per genome
+// it relies on every genome having the same type and length with each field group on its own
+// line and returns non-zero without changing anything if the file does not match
+int Population::ReadPopulationFast(const char *filename)
+{
+    MappedFile file;
+    if (file.Open(filename)) return __LINE__;
+    const char *begin = file.GetData();
+    const char *end = begin + file.GetSize();
+
+    // the header and the first genome define the layout
+    size_t populationSize;
+    int genomeType;
+    size_t genomeLength;
+    const char *ptr = EndOfLine(ParseNumber(begin, end, &populationSize), end);
+    if (!ptr || populationSize == 0) return __LINE__;
+    if (!ParseNumber(EndOfLine(ParseNumber(ptr, end, &genomeType), end), end, &genomeLength)) return __LINE__;
+    if (genomeType != Genome::IndividualRanges && genomeType != Genome::IndividualCircularMutation) return __LINE__;
+    if (genomeLength == 0 || populationSize > std::numeric_limits<uint32_t>::max()) return __LINE__;
+    size_t linesPerGenome = genomeLength + 3;
+
+    size_t threadCount = std::max(size_t(1), size_t(std::thread::hardware_concurrency()));
+    threadCount = std::min(threadCount, std::max(size_t(1), file.GetSize() / (size_t(1) << 20))); // at least 1MB each
+    size_t chunkSize = file.GetSize() / threadCount + 1;
+
+    // count the lines in each chunk so each thread knows where its genomes start
+    std::vector<size_t> linesBefore(threadCount + 1, 0);
+    {
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < threadCount; t++)
+        {
+            threads.emplace_back([&, t]()
+            {
+                const char *chunkBegin = std::min(begin + t * chunkSize, end);
+                const char *chunkEnd = std::min(chunkBegin + chunkSize, end);
+                linesBefore[t + 1] = size_t(std::count(chunkBegin, chunkEnd, '\n'));
+            });
+        }
+        for (auto &&it : threads) it.join();
+        for (size_t t = 0; t < threadCount; t++) linesBefore[t + 1] += linesBefore[t];
+    }
+
+    GeneArena arena;
+    arena.Initialise(genomeLength, populationSize + 1);
+    for (size_t i = 0; i < populationSize; i++) arena.Allocate(); // slot i holds genome i
+    std::vector<std::shared_ptr<const GenomeSchema>> schemas(populationSize);
+    std::vector<size_t> parsedCount(threadCount, 0);
+    std::atomic<bool> parseError(false);
+    {
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < threadCount; t++)
+        {
+            threads.emplace_back([&, t]()
+            {
+                const char *chunkBegin = std::min(begin + t * chunkSize, end);
+                const char *chunkEnd = std::min(chunkBegin + chunkSize, end);
+                const char *lineStart = chunkBegin;
+                size_t line = linesBefore[t];
+                if (lineStart != begin && lineStart[-1] != '\n')
+                {
+                    lineStart = static_cast<const char *>(std::memchr(lineStart, '\n', size_t(end - lineStart)));
+                    if (!lineStart) return;
+                    lineStart++;
+                    line++;
+                }
+                std::vector<double> lowBounds(genomeLength), highBounds(genomeLength), gaussianSDs(genomeLength);
+                std::vector<char> circularMutationFlags(genomeLength);
+                std::shared_ptr<const GenomeSchema> lastSchema;
+                while (lineStart < chunkEnd && !parseError)
+                {
+                    if (line == 0 || (line - 1) % linesPerGenome != 0)
+                    {
+                        // not the start of a genome so go to the next line
+                        lineStart = static_cast<const char *>(std::memchr(lineStart, '\n', size_t(end - lineStart)));
+                        if (!lineStart) break;
+                        lineStart++;
+                        line++;
+                        continue;
+                    }
+                    size_t index = (line - 1) / linesPerGenome;
+                    if (index >= populationSize) break;
+
+                    int type;
+                    size_t length;
+                    const char *p = EndOfLine(ParseNumber(lineStart, end, &type), end);
+                    p = EndOfLine(ParseNumber(p, end, &length), end);
+                    if (!p || type != genomeType || length != genomeLength) { parseError = true; break; }
+                    double *genes = arena.GetGenes(index);
+                    bool sameSchema = bool(lastSchema);
+                    for (size_t i = 0; i < genomeLength && p; i++)
+                    {
+                        p = ParseNumber(p, end, &genes[i]);
+                        p = ParseNumber(p, end, &lowBounds[i]);
+                        p = ParseNumber(p, end, &highBounds[i]);
+                        p = ParseNumber(p, end, &gaussianSDs[i]);
+                        if (genomeType == Genome::IndividualCircularMutation) p = ParseFlag(p, end, &circularMutationFlags[i]);
+                        p = EndOfLine(p, end);
+                        if (sameSchema && p)
+                            sameSchema = lowBounds[i] == lastSchema->GetLowBound(i) && highBounds[i] == lastSchema->GetHighBound(i) &&
+                                         gaussianSDs[i] == lastSchema->GetGaussianSD(i) && circularMutationFlags[i] == lastSchema->GetCircularMutationFlag(i);
+                    }
+                    double fitness;
+                    int dummy;
+                    p = ParseNumber(p, end, &fitness);
+                    for (int i = 0; i < 4; i++) p = ParseNumber(p, end, &dummy);
+                    p = EndOfLine(p, end);
+                    if (!p) { parseError = true; break; }
+                    arena.SetFitness(index, fitness);
+                    if (!sameSchema)
+                        lastSchema = std::make_shared<const GenomeSchema>(Genome::GenomeType(genomeType), std::vector<double>(lowBounds), std::vector<double>(highBounds),
+                                                                          std::vector<double>(gaussianSDs), std::vector<char>(circularMutationFlags), false);
+                    schemas[index] = lastSchema;
+                    parsedCount[t]++;
+                    lineStart = p;
+                    line += linesPerGenome;
+                }
+            });
+        }
+        for (auto &&it : threads) it.join();
+    }
+    size_t totalParsed = 0;
+    for (auto &&it : parsedCount) totalParsed += it;
+    if (parseError || totalParsed != populationSize) return __LINE__;
+
+    // each thread only shared schemas with its own genomes so share across the chunk boundaries too
+    std::shared_ptr<const GenomeSchema> lastOriginal = schemas[0], lastShared = schemas[0];
+    for (size_t i = 1; i < populationSize; i++)
+    {
+        if (schemas[i] == lastOriginal) schemas[i] = lastShared;
+        else if (*schemas[i] == *lastShared)
+        {
+            lastOriginal = schemas[i];
+            schemas[i] = lastShared;
+        }
+        else lastOriginal = lastShared = schemas[i];
+    }
+
+    // now replace the current population
+    m_Arena = std::move(arena);
+    m_Schemas = std::move(schemas);
+    m_Schemas.resize(m_Arena.GetCapacity());
+    m_ImmortalListIndex.clear();
+    m_AgeList.clear();
+    m_Stats.Clear();
+    std::vector<std::pair<PopulationKey, size_t>> entries(populationSize);
+    for (size_t i = 0; i < populationSize; i++)
+    {
+        // this is the same order that InsertGenome would have seen them
+        PopulationKey key = {m_Arena.GetFitness(i), i};
+        entries[i] = std::make_pair(key, i);
+        m_Stats.Add(key.fitness);
+        AddToAgeLists(key);
+    }
+    std::sort(entries.begin(), entries.end(), [](const std::pair<PopulationKey, size_t> &a, const std::pair<PopulationKey, size_t> &b) { return a.first < b.first; });
+    m_Population.BuildFromSorted(std::move(entries));
+    m_NextSequence = populationSize;
+    m_TargetPopulationSize = populationSize;
+    return 0;
+}
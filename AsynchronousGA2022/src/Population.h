@@ -11,26 +11,34 @@
 #define POPULATION_H
 
 #include "Genome.h"
+#include "GeneArena.h"
+#include "OrderStatisticTree.h"
+#include "SelectionSampler.h"
+#include "Statistics.h"
 
 #include <deque>
-#include <map>
+#include <vector>
+#include <memory>
+#include <cstdint>
 
 class Random;
 
-enum SelectionType
-{
-    UniformSelection,
-    RankBasedSelection,
-    SqrtBasedSelection,
-    GammaBasedSelection
-};
-
 enum ResizeControl
 {
     RandomiseResize,
     MutateResize
 };
 
+// the population is sorted by fitness and genomes with the same fitness are
+// kept in the order they arrived using the sequence number
+struct PopulationKey
+{
+    double fitness;
+    uint64_t sequence;
+
+    bool operator<(const PopulationKey &in) const { return fitness < in.fitness || (fitness == in.fitness && sequence < in.sequence); }
+};
+
 class Population
 {
 public:
@@ -38,10 +46,18 @@ public:
 
     void InitialisePopulation(size_t populationSize, const Genome &genome);
 
-    Genome *GetFirstGenome() { return &m_Population.begin()->second; }
-    Genome *GetLastGenome() { return &m_Population.rbegin()->second; }
-    Genome *GetGenome(size_t i) { return &m_Population[m_PopulationIndex[i]]; }
-    size_t GetPopulationSize() { return m_Population.size(); }
+    // the genomes are stored in the arena so these copy them out
+    void GetFirstGenome(Genome *genome) { CopyGenome(m_Population.Front(), genome); }
+    void GetLastGenome(Genome *genome) { CopyGenome(m_Population.Back(), genome); }
+    void GetGenome(size_t i, Genome *genome) { CopyGenome(m_Population.Select(i), genome); }
+    // and these access them in place (the pointers are valid until the population next grows)
+    const double *GetGenes(size_t i) { return m_Arena.GetGenes(m_Population.Select(i)); }
+    const std::shared_ptr<const GenomeSchema> &GetSchema(size_t i) { return m_Schemas[m_Population.Select(i)]; }
+    double GetFitness(size_t i) { return m_Arena.GetFitness(m_Population.Select(i)); }
+    double GetLastFitness() { return m_Arena.GetFitness(m_Population.Back()); }
+    size_t GetPopulationSize() { return m_Population.Size(); }
+    size_t GetGenomeLength() { return m_Arena.GetGenomeLength(); }
+    const PopulationStats *GetPopulationStats();
 
     void SetSelectionType(SelectionType type) { m_SelectionType = type; }
     void SetParentsToKeep(size_t parentsToKeep) { m_ParentsToKeep = parentsToKeep; if (m_ParentsToKeep < 0) m_ParentsToKeep = 0; }
@@ -49,9 +65,9 @@ public:
     void SetResizeControl(ResizeControl control) { m_ResizeControl = control; }
     void SetGamma(double gamma) { m_Gamma = gamma; }
 
-    Genome *ChooseParent(size_t *parentRank, Random *random);
+    const double *ChooseParent(size_t *parentRank, Random *random);
     void Randomise(Random *random);
-    int InsertGenome(Genome &&genome, size_t targetPopulationSize);
+    int InsertGenome(const Genome &genome, size_t targetPopulationSize);
     void ResizePopulation(size_t size, Random *random);
 
     int ReadPopulation(const char *filename);
@@ -59,10 +75,21 @@ public:
 
 protected:
 
-    std::map<double, Genome> m_Population;
-    std::vector<double> m_PopulationIndex; // sorted vector
-    std::vector<double> m_ImmortalListIndex; // sorted vector
-    std::deque<double> m_AgeList;
+    PopulationKey AddToPopulation(const Genome &genome);
+    void AddToAgeLists(const PopulationKey &key);
+    int ReadPopulationFast(const char *filename);
+    bool RemoveFromPopulation(const PopulationKey &key);
+    void CopyGenome(size_t slot, Genome *genome);
+
+    OrderStatisticTree<PopulationKey, size_t> m_Population; // arena slots sorted by fitness and indexable by rank
+    GeneArena m_Arena;
+    std::vector<std::shared_ptr<const GenomeSchema>> m_Schemas; // indexed by arena slot
+    std::vector<PopulationKey> m_ImmortalListIndex; // sorted vector
+    std::deque<PopulationKey> m_AgeList;
+    uint64_t m_NextSequence = 0;
+    SelectionSampler m_Sampler;
+    PopulationStats m_Stats;
+    size_t m_TargetPopulationSize = 0;
     SelectionType m_SelectionType = RankBasedSelection;
     size_t m_ParentsToKeep = 0;
     ResizeControl m_ResizeControl = MutateResize;
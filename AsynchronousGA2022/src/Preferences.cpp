@@ -26,6 +26,7 @@ int Preferences::ReadPreferences(const std::string &filename)
     try
     {
         if (params.ReadFile(filename)) throw __LINE__;
+        params.BuildParameterIndex();
 
         // essential parameters
         if (params.RetrieveParameter("genomeLength", &genomeLength)) throw __LINE__;
@@ -72,6 +73,17 @@ int Preferences::ReadPreferences(const std::string &filename)
 
         // optional parameters
         params.RetrieveParameter("startingPopulation", &startingPopulation);
+        params.RetrieveParameter("outputStatistics", &outputStatistics);
+        params.RetrieveParameter("geometricSkipMutation", &geometricSkipMutation);
+        params.RetrieveParameter("clampShiftedGenes", &clampShiftedGenes);
+        params.RetrieveParameter("validateOffspring", &validateOffspring);
+        params.RetrieveParameter("maxOffspringRejections", &maxOffspringRejections);
+        if (!params.RetrieveParameter("randomNumberGenerator", &paramsBuffer))
+        {
+            if (paramsBuffer == "Xoshiro256PlusPlus"s) randomNumberGenerator = Random::Xoshiro256PlusPlusGenerator;
+            else if (paramsBuffer == "MersenneTwister"s) randomNumberGenerator = Random::MersenneTwisterGenerator;
+            else throw __LINE__;
+        }
 
     }
 
@@ -110,6 +122,12 @@ std::string Preferences::GetPreferencesString()
     out << "watchDogTimerLimit " << watchDogTimerLimit << "\n";
     out << "circularMutation " << circularMutation << "\n";
     out << "bounceMutation " << bounceMutation << "\n";
+    out << "outputStatistics " << outputStatistics << "\n";
+    out << "geometricSkipMutation " << geometricSkipMutation << "\n";
+    out << "clampShiftedGenes " << clampShiftedGenes << "\n";
+    out << "validateOffspring " << validateOffspring << "\n";
+    out << "maxOffspringRejections " << maxOffspringRejections << "\n";
+    out << "randomNumberGenerator " << (randomNumberGenerator == Random::MersenneTwisterGenerator ? "MersenneTwister\n" : "Xoshiro256PlusPlus\n");
 
     switch (parentSelection)
     {
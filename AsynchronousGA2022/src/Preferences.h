@@ -50,6 +50,12 @@ public:
     bool circularMutation = false;
     bool bounceMutation = true;
     ResizeControl resizeControl = MutateResize;
+    bool outputStatistics = false;
+    bool geometricSkipMutation = false;
+    bool clampShiftedGenes = false;
+    bool validateOffspring = false;
+    int maxOffspringRejections = 1000;
+    Random::GeneratorType randomNumberGenerator = Random::Xoshiro256PlusPlusGenerator;
 };
 
 #endif // PREFERENCES_H
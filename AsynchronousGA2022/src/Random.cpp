@@ -12,16 +12,53 @@
 #include <cmath>
 #include <memory>
 
+namespace
+{
+// tables for the 256 layer ziggurat (Marsaglia and Tsang, Journal of Statistical Software 5(8), 2000)
+// x[i] is the right hand edge of layer i and f[i] is the unnormalised density exp(-x^2/2) there
+// layer 0 is the base strip which includes the tail beyond R
+// the tables are built once when the program starts and never change after that
+struct ZigguratTables
+{
+    static constexpr double R = 3.6541528853610088;
+    static constexpr double V = 4.92867323399e-3; // the area of each layer
+    double x[257];
+    double f[257];
+    ZigguratTables()
+    {
+        double fR = std::exp(-0.5 * R * R);
+        x[0] = V / fR;
+        x[1] = R;
+        for (int i = 1; i < 255; i++)
+            x[i + 1] = std::sqrt(-2.0 * std::log(V / x[i] + std::exp(-0.5 * x[i] * x[i])));
+        x[256] = 0;
+        for (int i = 0; i < 257; i++) f[i] = std::exp(-0.5 * x[i] * x[i]);
+    }
+};
+const ZigguratTables zigguratTables;
+}
+
 Random::Random()
 {
     std::random_device randomDevice;
-    m_randomNumberGenerator.seed(randomDevice());
+    uint64_t seed = (uint64_t(randomDevice()) << 32) ^ uint64_t(randomDevice());
+    RandomSeed(seed);
 }
 
 // set the random number generator seed
+// both generators are seeded so that switching between them is repeatable
 void Random::RandomSeed(uint64_t randomSeed)
 {
-    m_randomNumberGenerator.seed(randomSeed);
+    m_xoshiro.seed(randomSeed);
+    m_mersenneTwister.seed(randomSeed);
+}
+
+// move on to a stream that does not overlap the current one
+// xoshiro256++ jumps ahead 2^128 numbers but the Mersenne Twister cannot jump so it is reseeded from itself
+void Random::Jump()
+{
+    m_xoshiro.Jump();
+    m_mersenneTwister.seed(m_mersenneTwister());
 }
 
 // random double between limits
@@ -30,17 +67,33 @@ void Random::RandomSeed(uint64_t randomSeed)
 double Random::RandomDouble(double lowBound, double highBound)
 {
     if (lowBound >= highBound) return lowBound;
-    std::uniform_real_distribution<double> doubleDistribution(lowBound, highBound);
-    return doubleDistribution(m_randomNumberGenerator);
+    double v = lowBound + (highBound - lowBound) * UnitDouble();
+    if (v >= highBound) v = std::nextafter(highBound, lowBound); // rounding errors
+    return v;
 }
 
 // random int between limits
 // the value can definitely equal both boundaries
+// this uses Lemire's multiply and shift method (ACM Transactions on Modeling and Computer Simulation 29(1), 2019)
+// which only needs a division for the rare values that have to be rejected to avoid any bias
 int Random::RandomInt(int lowBound, int highBound)
 {
     if (lowBound >= highBound) return lowBound;
-    std::uniform_int_distribution<int> intDistribution(lowBound, highBound);
-    return intDistribution(m_randomNumberGenerator);
+    uint64_t range = uint64_t(int64_t(highBound) - int64_t(lowBound)) + 1;
+    if (range > 0xFFFFFFFFULL) return int(int64_t(lowBound) + int64_t(NextUInt64() >> 32)); // the whole range of int
+    uint32_t range32 = uint32_t(range);
+    uint64_t m = (NextUInt64() >> 32) * range;
+    uint32_t leftover = uint32_t(m);
+    if (leftover < range32)
+    {
+        uint32_t threshold = uint32_t(0 - range32) % range32;
+        while (leftover < threshold)
+        {
+            m = (NextUInt64() >> 32) * range;
+            leftover = uint32_t(m);
+        }
+    }
+    return int(int64_t(lowBound) + int64_t(m >> 32));
 }
 
 // square root biased random int between limits
@@ -88,68 +141,19 @@ int Random::GammaBiasedRandomInt(int lowBound, int highBound, double gamma)
     return i;
 }
 
-// rank biased random int between limit
-// higher numbers more likely
-// can't cope with more than a few tens of thousands
-// unchecked!
+// rank biased random int between limits
+// higher numbers more likely with the chance proportional to 1 + value - lowBound
+// the cumulative weight is a triangular number so it can be inverted directly
+// (Population uses SelectionSampler which is quicker for repeated draws)
 int Random::RankBiasedRandomInt(int lowBound, int highBound)
 {
     if (lowBound >= highBound) return lowBound;
-    static int myLowBound = 0;
-    static int myHighBound = 0;
-    static int n = 0;
-    static int total = 0;
-    static std::unique_ptr<int[]> cumulative;
-    int i, j;
-
-    // slow initialisation only done once
-    if (myLowBound != lowBound || myHighBound != highBound)
-    {
-        myLowBound = lowBound;
-        myHighBound = highBound;
-        n = 1 + myHighBound - myLowBound;
-        cumulative = std::make_unique<int[]>(n);
-
-        // produce a cumulative map
-        j = 0;
-        for (i = myLowBound; i <= myHighBound; i++)
-        {
-            total += i;
-            cumulative[j] = total;
-            j++;
-        }
-    }
-
-    // get a random int
-    j = RandomInt(0, total);
-
-    // and search for it in the list
-    int lower = 0;
-    int upper = n - 1;
-    int pivot = (upper - lower) / 2;
-    int delta;
-
-    while (true)
-    {
-        if (pivot == 0) break;
-        if (cumulative[pivot - 1] < j && cumulative[pivot] >= j) break;
-        if (j > cumulative[pivot])
-        {
-            lower = pivot;
-            delta = (upper - lower) / 2;
-            if (delta == 0) delta = 1;
-            pivot += delta;
-        }
-        else
-        {
-            upper = pivot;
-            delta = (upper - lower) / 2;
-            if (delta == 0) delta = 1;
-            pivot -= delta;
-        }
-    }
-
-    return pivot + myLowBound;
+    double n = 1.0 + double(highBound) - double(lowBound);
+    double x = RandomDouble(0.0, 1.0) * n * (n + 1.0) / 2.0;
+    double v = (std::sqrt(1.0 + 8.0 * x) - 1.0) / 2.0;
+    int i = lowBound + static_cast<int>(v);
+    if (i > highBound) i = highBound; // rounding errors
+    return i;
 }
 
 // random coin flip - returns true a proportion of the time that
@@ -157,49 +161,65 @@ int Random::RankBiasedRandomInt(int lowBound, int highBound)
 bool Random::CoinFlip(double chanceOfReturningTrue)
 {
     if (chanceOfReturningTrue == 0) return false;
-    if (RandomDouble(0.0, 1.0) < chanceOfReturningTrue) return true;
-    else return false;
+    return UnitDouble() < chanceOfReturningTrue;
 }
 
-// unit gaussian routine from galib
 // Return a number from a unit Gaussian distribution.  The mean is 0 and the
 // standard deviation is 1.0.
-//   First we generate two uniformly random variables inside the complex unit
-// circle.  Then we transform these into Gaussians using the Box-Muller
-// transformation.  This method is described in Numerical Recipes in C
-// ISBN 0-521-43108-5 at http://world.std.com/~nr
-//   When we find a number, we also find its twin, so we cache that here so
-// that every other call is a lookup rather than a calculation.  (I think GNU
-// does this in their implementations as well, but I don't remember for
-// certain.)
+// This uses the ziggurat method. One 64 bit number gives the layer (bottom 8 bits)
+// and the position across it (top 53 bits) and about 99% of the time that is all
+// that is needed. Otherwise the point is checked against the curve or the tail is sampled.
 double Random::RandomUnitGaussian()
 {
-    static bool cached = false;
-    static double cachevalue;
-    if (cached == true)
+    const double *x = zigguratTables.x;
+    const double *f = zigguratTables.f;
+    while (true)
     {
-        cached = false;
-        return cachevalue;
+        uint64_t bits = NextUInt64();
+        size_t i = size_t(bits & 0xFF);
+        double u = double(bits >> 11) * (2.0 / 9007199254740992.0) - 1.0; // from -1 to 1
+        double v = u * x[i];
+        if (std::fabs(v) < x[i + 1]) return v; // inside the rectangle that is completely under the curve
+        if (i == 0) return GaussianTail(u < 0);
+        if (f[i + 1] + (f[i] - f[i + 1]) * UnitDouble() < std::exp(-0.5 * v * v)) return v;
     }
+}
 
-    double rsquare, factor, var1, var2;
+// sample from the tail beyond R using Marsaglia's method
+double Random::GaussianTail(bool negative)
+{
+    const double R = ZigguratTables::R;
+    double x, y;
     do
     {
-        var1 = 2.0 * RandomDouble(0.0, 1.0) - 1.0;
-        var2 = 2.0 * RandomDouble(0.0, 1.0) - 1.0;
-        rsquare = var1 * var1 + var2 * var2;
+        x = -std::log(1.0 - UnitDouble()) / R; // 1 - UnitDouble() is never 0
+        y = -std::log(1.0 - UnitDouble());
     }
-    while (rsquare >= 1.0 || rsquare == 0.0);
-
-    double val = -2.0 * log(rsquare) / rsquare;
-    if (val > 0.0)
-        factor = sqrt(val);
-    else
-        factor = 0.0;  // should not happen, but might due to roundoff
+    while (y + y < x * x);
+    return negative ? -(R + x) : R + x;
+}
 
-    cachevalue = var1 * factor;
-    cached = true;
+// fill an array with uniform doubles from 0 to 1 (never 1)
+void Random::RandomUnitDoubles(double *values, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        values[i] = UnitDouble();
+}
 
-    return (var2 * factor);
+// fill an array with unit gaussian values
+void Random::RandomUnitGaussians(double *values, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        values[i] = RandomUnitGaussian();
 }
 
+// the number of failures before the next success when each trial succeeds with chance p
+// logFailureChance is log(1 - p) so that it only needs calculating once
+// very long gaps are capped at 1e18 which is far longer than anything they are used for
+uint64_t Random::RandomGeometricGap(double logFailureChance)
+{
+    double u = 1.0 - UnitDouble(); // from 0 (never 0) to 1
+    double gap = std::floor(std::log(u) / logFailureChance);
+    if (!(gap < 1e18)) return uint64_t(1e18);
+    return uint64_t(gap);
+}
@@ -10,24 +10,55 @@
 #ifndef RANDOM_H
 #define RANDOM_H
 
+#include "Xoshiro256PlusPlus.h"
+
 #include <random>
+#include <cstdint>
+#include <cstddef>
 
+// The generator can be xoshiro256++ (the default, fast, with Jump for separate streams)
+// or the standard 64 bit Mersenne Twister. The distributions are done here rather than
+// with the <random> distribution classes so nothing is created for each number, and
+// there is no hidden state so separate Random objects can be used by separate threads.
 class Random
 {
 public:
+    enum GeneratorType
+    {
+        Xoshiro256PlusPlusGenerator,
+        MersenneTwisterGenerator
+    };
+
     Random();
 
+    void SetGeneratorType(GeneratorType generatorType) { m_generatorType = generatorType; }
+    GeneratorType GetGeneratorType() const { return m_generatorType; }
     void RandomSeed(uint64_t randomSeed);
+    void Jump();
+
     double RandomDouble(double lowBound, double highBound);
     int RandomInt(int lowBound, int highBound);
     bool CoinFlip(double chanceOfReturningTrue = 0.5);
     int SqrtBiasedRandomInt(int lowBound, int highBound);
     double RandomUnitGaussian();
+    void RandomUnitDoubles(double *values, size_t n);
+    void RandomUnitGaussians(double *values, size_t n);
+    uint64_t RandomGeometricGap(double logFailureChance);
     int RankBiasedRandomInt(int lowBound, int highBound);
     int GammaBiasedRandomInt(int lowBound, int highBound, double gamma);
 
 private:
-    std::mt19937_64 m_randomNumberGenerator;
+    inline uint64_t NextUInt64();
+    inline double UnitDouble();
+    double GaussianTail(bool negative);
+
+    Xoshiro256PlusPlus m_xoshiro;
+    std::mt19937_64 m_mersenneTwister;
+    GeneratorType m_generatorType = Xoshiro256PlusPlusGenerator;
 };
 
+inline uint64_t Random::NextUInt64() { return m_generatorType == Xoshiro256PlusPlusGenerator ? m_xoshiro() : m_mersenneTwister(); }
+// from 0 to 1 (never 1) using the top 53 bits
+inline double Random::UnitDouble() { return double(NextUInt64() >> 11) * (1.0 / 9007199254740992.0); }
+
 #endif // RANDOM_H
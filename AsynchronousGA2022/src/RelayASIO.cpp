@@ -0,0 +1,293 @@
+#include "RelayASIO.h"
+#include "GAASIO.h"
+#include "MD5.h"
+
+#include "pystring.h"
+
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+#include <cinttypes>
+
+using namespace std::string_literals;
+
+RelayASIO::RelayASIO()
+{
+}
+
+int RelayASIO::Process(const std::string &upstreamAddress, int upstreamConnections)
+{
+    size_t colon = upstreamAddress.rfind(':');
+    if (colon == std::string::npos || colon == 0 || colon == upstreamAddress.size() - 1)
+    {
+        ReportProgress("Error: relay address \""s + upstreamAddress + "\" should be in the form host:port"s, 0);
+        return __LINE__;
+    }
+    m_upstreamHost = upstreamAddress.substr(0, colon);
+    m_upstreamPort = uint16_t(std::atoi(upstreamAddress.c_str() + colon + 1));
+    if (upstreamConnections < 1) upstreamConnections = 1;
+
+    // start the TCP server for the local clients
+    m_server = new ServerASIO();
+    if (m_server->setPort(uint16_t(m_tcpPort)))
+    {
+        ReportProgress(GAMain::ToString("Unable to set listening port to %d", m_tcpPort), 0);
+        delete m_server;
+        m_server = nullptr;
+        return __LINE__;
+    }
+    m_server->attach("req_gen_"s, std::bind(&RelayASIO::handleRequestGenome, this, std::placeholders::_1));
+    m_server->attach("req_xml_"s, std::bind(&RelayASIO::handleRequestXML, this, std::placeholders::_1));
+    m_server->attach("score___"s, std::bind(&RelayASIO::handleScore, this, std::placeholders::_1));
+    // replies from the master use the DataMessage text field as the command so they are zero padded
+    // and they are only accepted on the connections to the master
+    m_server->attachOutgoing(std::string("genome\0\0", 8), std::bind(&RelayASIO::handleGenome, this, std::placeholders::_1));
+    m_server->attachOutgoing(std::string("xml\0\0\0\0\0", 8), std::bind(&RelayASIO::handleXML, this, std::placeholders::_1));
+
+    // the connections to the master are opened in the background once the io_context thread is running
+    // so the relay starts even if the master is not up yet
+    m_upstream.resize(size_t(upstreamConnections));
+    m_reconnectTime.assign(m_upstream.size(), 0);
+    m_reconnecting.assign(m_upstream.size(), 0);
+    m_server->post(std::bind(&RelayASIO::Housekeeping, this));
+    ReportProgress(GAMain::ToString("Relay listening on port %d with %d connections to %s", m_tcpPort, upstreamConnections, upstreamAddress.c_str()), 0);
+
+    std::thread serverThread(&ServerASIO::start, m_server);
+    bool shouldStop = false;
+    double lastHousekeepingTime = CurrentTime();
+    double housekeepingInterval = 1;
+    while (shouldStop == false)
+    {
+        if (GAMain::pollStdin())
+        {
+            std::string instruction;
+            std::getline(std::cin, instruction);
+            instruction = pystring::strip(instruction);
+            if (instruction == "stop"s)
+            {
+                shouldStop = true;
+                ReportProgress("Stopped by user"s, 0);
+            }
+            if (instruction.rfind("log"s, 0) == 0)
+            {
+                m_logLevel = std::atoi(instruction.c_str() + 3); // used std::atoi rather that std::stoi because std::atoi does not throw exceptions
+                ReportProgress(GAMain::ToString("Log level changed to %d", int(m_logLevel)), 0);
+            }
+        }
+        double currentTime = CurrentTime();
+        if (currentTime >= lastHousekeepingTime + housekeepingInterval)
+        {
+            lastHousekeepingTime = currentTime;
+            m_server->post(std::bind(&RelayASIO::Housekeeping, this));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    // the io_context thread has to finish before the upstream sessions are released
+    // and the sessions need to go before the io_context that owns their sockets
+    m_server->stop();
+    serverThread.join();
+    m_upstream.clear();
+    delete m_server;
+    m_server = nullptr;
+    return 0;
+}
+
+void RelayASIO::handleRequestGenome(MessageASIO message)
+{
+    if (message.content.size() < sizeof(GAMain::RequestMessage)) return;
+    if (message.session.expired()) return;
+    double currentTime = CurrentTime();
+
+    // only one outstanding request per client unless the master has failed to answer for a long time
+    auto pendingIt = m_pendingClients.find(message.session);
+    if (pendingIt != m_pendingClients.end())
+    {
+        auto ticketIt = m_pendingGenomes.find(pendingIt->second);
+        if (ticketIt != m_pendingGenomes.end())
+        {
+            if (currentTime - ticketIt->second.requestTime < m_resendInterval) return;
+            m_pendingGenomes.erase(ticketIt);
+        }
+        m_pendingClients.erase(pendingIt);
+    }
+
+    auto upstream = Upstream();
+    if (!upstream) return;
+
+    // the request is forwarded as a relaygen request with the ticket in senderPort
+    // and the master echoes the ticket back in the DataMessage so the reply can be routed
+    uint32_t ticket = m_nextTicket++;
+    std::string content = message.content;
+    GAMain::RequestMessage *requestPtr = reinterpret_cast<GAMain::RequestMessage *>(content.data());
+    std::copy_n("relaygen", 8, requestPtr->text);
+    requestPtr->senderPort = ticket;
+    m_pendingGenomes[ticket] = {message.session, currentTime};
+    m_pendingClients[message.session] = ticket;
+    upstream->write(content.data(), content.size());
+    ReportProgress(GAMain::ToString("Genome request ticket %" PRIu32 " forwarded", ticket), 2);
+}
+
+void RelayASIO::handleRequestXML(MessageASIO message)
+{
+    if (message.content.size() < sizeof(GAMain::RequestMessage)) return;
+    if (m_currentMD5.size())
+    {
+        auto cacheIt = m_xmlCache.find(m_currentMD5);
+        if (cacheIt != m_xmlCache.end())
+        {
+            if (auto sharedPtr = message.session.lock())
+                sharedPtr->write(cacheIt->second.data(), cacheIt->second.size());
+            ReportProgress(GAMain::ToString("XML %zu bytes sent from cache", cacheIt->second.size()), 2);
+            return;
+        }
+    }
+
+    // not cached so ask the master but only once for all the clients that are waiting
+    double currentTime = CurrentTime();
+    m_pendingXML.push_back(message.session);
+    if (m_pendingXML.size() == 1 || currentTime - m_pendingXMLTime > m_resendInterval)
+    {
+        auto upstream = Upstream();
+        if (!upstream) return;
+        upstream->write(message.content.data(), message.content.size());
+        m_pendingXMLTime = currentTime;
+        ReportProgress("XML request forwarded"s, 2);
+    }
+}
+
+void RelayASIO::handleScore(MessageASIO message)
+{
+    if (message.content.size() < sizeof(GAMain::RequestMessage)) return;
+    // scores contain the runID and evolveIdentifier so they can be passed on unchanged
+    auto upstream = Upstream();
+    if (!upstream) return;
+    upstream->write(message.content.data(), message.content.size());
+}
+
+void RelayASIO::handleGenome(MessageASIO message)
+{
+    if (message.content.size() < sizeof(GAMain::DataMessage)) return;
+    GAMain::DataMessage *dataMessagePtr = reinterpret_cast<GAMain::DataMessage *>(message.content.data());
+    m_currentMD5 = hexDigest(dataMessagePtr->md5);
+    uint32_t ticket = dataMessagePtr->senderPort;
+    auto ticketIt = m_pendingGenomes.find(ticket);
+    if (ticketIt == m_pendingGenomes.end())
+    {
+        ReportProgress(GAMain::ToString("Genome for unknown ticket %" PRIu32 " discarded", ticket), 1);
+        return;
+    }
+    auto client = ticketIt->second.client.lock();
+    m_pendingClients.erase(ticketIt->second.client);
+    m_pendingGenomes.erase(ticketIt);
+    if (!client)
+    {
+        ReportProgress(GAMain::ToString("Client for ticket %" PRIu32 " has gone", ticket), 1);
+        return;
+    }
+    dataMessagePtr->senderPort = 0; // so the client sees exactly what it would get from the master
+    client->write(message.content.data(), message.content.size());
+    ReportProgress(GAMain::ToString("Sample %" PRIu32 " ticket %" PRIu32 " sent", dataMessagePtr->runID, ticket), 2);
+}
+
+void RelayASIO::handleXML(MessageASIO message)
+{
+    if (message.content.size() < sizeof(GAMain::DataMessage)) return;
+    const GAMain::DataMessage *dataMessagePtr = reinterpret_cast<const GAMain::DataMessage *>(message.content.data());
+    std::string md5String = hexDigest(dataMessagePtr->md5);
+    if (m_currentMD5.empty()) m_currentMD5 = md5String;
+    // keep a small number of cached files in case the master is restarted with a new model
+    for (auto it = m_xmlCache.begin(); it != m_xmlCache.end() && m_xmlCache.size() >= m_maxCachedXML;)
+    {
+        if (it->first != m_currentMD5) it = m_xmlCache.erase(it);
+        else it++;
+    }
+    std::string &cached = m_xmlCache[md5String];
+    cached = std::move(message.content);
+    ReportProgress(GAMain::ToString("XML %zu bytes cached with MD5 %s", cached.size(), md5String.c_str()), 1);
+
+    for (auto &&it : m_pendingXML)
+    {
+        if (auto sharedPtr = it.lock())
+            sharedPtr->write(cached.data(), cached.size());
+    }
+    m_pendingXML.clear();
+}
+
+// round robin through the upstream connections
+// connections that are not open yet or have closed are opened in the background and skipped until they are up
+std::shared_ptr<SessionASIO> RelayASIO::Upstream()
+{
+    double currentTime = CurrentTime();
+    for (size_t i = 0; i < m_upstream.size(); i++)
+    {
+        size_t index = m_nextUpstream % m_upstream.size();
+        m_nextUpstream++;
+        if (m_upstream[index] && m_upstream[index]->isOpen()) return m_upstream[index];
+        Reconnect(index, currentTime);
+    }
+    ReportProgress("Error: no upstream connection available"s, 0);
+    return nullptr;
+}
+
+// a master that is down is only retried every m_reconnectInterval seconds
+void RelayASIO::Reconnect(size_t index, double currentTime)
+{
+    if (m_reconnecting[index] || currentTime - m_reconnectTime[index] < m_reconnectInterval) return;
+    ReportProgress(GAMain::ToString("Opening upstream connection %zu", index), 1);
+    m_reconnecting[index] = 1;
+    m_reconnectTime[index] = currentTime;
+    m_server->asyncConnect(m_upstreamHost, m_upstreamPort, [this, index](std::shared_ptr<SessionASIO> session)
+    {
+        m_reconnecting[index] = 0;
+        if (!session)
+        {
+            ReportProgress(GAMain::ToString("Error: unable to open upstream connection %zu", index), 1);
+            return;
+        }
+        m_upstream[index] = session;
+        ReportProgress(GAMain::ToString("Upstream connection %zu open", index), 1);
+    });
+}
+
+// called on the io_context thread from the main loop
+// drops requests whose client has gone or that the master has not answered and opens any connection that is not open
+void RelayASIO::Housekeeping()
+{
+    double currentTime = CurrentTime();
+    for (auto it = m_pendingGenomes.begin(); it != m_pendingGenomes.end();)
+    {
+        if (it->second.client.expired() || currentTime - it->second.requestTime >= m_resendInterval)
+        {
+            auto clientIt = m_pendingClients.find(it->second.client);
+            if (clientIt != m_pendingClients.end() && clientIt->second == it->first) m_pendingClients.erase(clientIt);
+            ReportProgress(GAMain::ToString("Genome request ticket %" PRIu32 " dropped", it->first), 2);
+            it = m_pendingGenomes.erase(it);
+        }
+        else { it++; }
+    }
+    for (auto it = m_pendingClients.begin(); it != m_pendingClients.end();)
+    {
+        if (it->first.expired() || m_pendingGenomes.count(it->second) == 0) it = m_pendingClients.erase(it);
+        else it++;
+    }
+    m_pendingXML.erase(std::remove_if(m_pendingXML.begin(), m_pendingXML.end(), [](const std::weak_ptr<SessionASIO> &client) { return client.expired(); }), m_pendingXML.end());
+
+    for (size_t i = 0; i < m_upstream.size(); i++)
+        if (!m_upstream[i] || !m_upstream[i]->isOpen()) Reconnect(i, currentTime);
+}
+
+void RelayASIO::ReportProgress(const std::string &message, int logLevel)
+{
+    if (m_logLevel >= logLevel)
+    {
+        std::cout << message << "\n";
+        std::cout.flush();
+    }
+}
+
+double RelayASIO::CurrentTime()
+{
+    return std::chrono::duration_cast<std::chrono::duration<double, std::chrono::seconds::period>>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,72 @@
+#ifndef RELAYASIO_H
+#define RELAYASIO_H
+
+#include "ServerASIO.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <atomic>
+
+// The relay sits between a group of local clients (typically on a cluster head node)
+// and the master GA server. It answers XML requests from a cache keyed by MD5 and
+// multiplexes all the genome requests and scores over a small number of long lived
+// upstream connections so the master only needs a handful of sockets per relay.
+class RelayASIO
+{
+public:
+    RelayASIO();
+
+    int Process(const std::string &upstreamAddress, int upstreamConnections);
+
+    void SetLogLevel(int logLevel) { m_logLevel = logLevel; }
+    void SetServerPort(int port) { m_tcpPort = port; }
+
+    // messages from the local clients
+    void handleRequestGenome(MessageASIO message);
+    void handleRequestXML(MessageASIO message);
+    void handleScore(MessageASIO message);
+
+    // messages from the master
+    void handleGenome(MessageASIO message);
+    void handleXML(MessageASIO message);
+
+private:
+    struct PendingRequest
+    {
+        std::weak_ptr<SessionASIO> client;
+        double requestTime;
+    };
+
+    std::shared_ptr<SessionASIO> Upstream();
+    void Reconnect(size_t index, double currentTime);
+    void Housekeeping();
+    void ReportProgress(const std::string &message, int logLevel);
+    static double CurrentTime();
+
+    ServerASIO *m_server = nullptr;
+    std::string m_upstreamHost;
+    std::uint16_t m_upstreamPort = 0;
+
+    // all the following are only accessed from the io_context thread once it is running
+    std::vector<std::shared_ptr<SessionASIO>> m_upstream;
+    std::vector<double> m_reconnectTime; // when each upstream connection was last tried
+    std::vector<char> m_reconnecting;
+    size_t m_nextUpstream = 0;
+    double m_reconnectInterval = 5;
+    uint32_t m_nextTicket = 0;
+    std::map<uint32_t, PendingRequest> m_pendingGenomes;
+    std::map<std::weak_ptr<SessionASIO>, uint32_t, std::owner_less<std::weak_ptr<SessionASIO>>> m_pendingClients;
+    std::map<std::string, std::string> m_xmlCache; // xml DataMessage indexed by MD5 hex digest
+    std::string m_currentMD5;
+    std::vector<std::weak_ptr<SessionASIO>> m_pendingXML;
+    double m_pendingXMLTime = 0;
+    double m_resendInterval = 60;
+    size_t m_maxCachedXML = 4;
+
+    std::atomic<int> m_logLevel = {0};
+    int m_tcpPort = 0;
+};
+
+#endif // RELAYASIO_H
@@ -0,0 +1,120 @@
+/*
+ *  SelectionSampler.cpp
+ *  AsynchronousGA
+ *
+ *  Created by Bill Sellers on 19/10/2026.
+ *  Copyright 2026 Bill Sellers. All rights reserved.
+ *
+ */
+
+#include "SelectionSampler.h"
+#include "Random.h"
+
+#include <cmath>
+
+SelectionSampler::SelectionSampler()
+{
+}
+
+// the chance of choosing rank from a population of size
+// these match the old Random::*BiasedRandomInt functions
+double SelectionSampler::Probability(SelectionType type, size_t rank, size_t size, double gamma)
+{
+    double r = double(rank);
+    double n = double(size);
+    switch (type)
+    {
+    case UniformSelection:
+        return 1.0 / n;
+    case RankBasedSelection:
+        return 2.0 * (r + 1.0) / (n * (n + 1.0)); // weight is rank + 1
+    case SqrtBasedSelection:
+        return (2.0 * r + 1.0) / (n * n); // floor(sqrt(u) * n)
+    case GammaBasedSelection:
+        return std::pow((r + 1.0) / n, 1.0 / gamma) - std::pow(r / n, 1.0 / gamma); // floor(pow(u, gamma) * n)
+    }
+    return 0;
+}
+
+// build the alias table using Vose's method
+void SelectionSampler::Build(SelectionType type, size_t size, double gamma)
+{
+    m_SelectionType = type;
+    m_Size = size;
+    m_Gamma = gamma;
+    m_Probability.clear();
+    m_Alias.clear();
+    if (type == UniformSelection || size < 2) return; // these do not need a table
+
+    m_Probability.resize(size);
+    m_Alias.resize(size);
+    std::vector<uint32_t> small, large;
+    small.reserve(size);
+    large.reserve(size);
+    for (size_t i = 0; i < size; i++)
+    {
+        m_Probability[i] = Probability(type, i, size, gamma) * double(size);
+        m_Alias[i] = uint32_t(i);
+        if (m_Probability[i] < 1.0) small.push_back(uint32_t(i));
+        else large.push_back(uint32_t(i));
+    }
+    while (small.size() && large.size())
+    {
+        uint32_t l = small.back();
+        small.pop_back();
+        uint32_t g = large.back();
+        large.pop_back();
+        m_Alias[l] = g;
+        m_Probability[g] = (m_Probability[g] + m_Probability[l]) - 1.0;
+        if (m_Probability[g] < 1.0) small.push_back(g);
+        else large.push_back(g);
+    }
+    // anything left over is only there because of rounding so it should always be kept
+    for (auto &&it : large) m_Probability[it] = 1.0;
+    for (auto &&it : small) m_Probability[it] = 1.0;
+}
+
+// choose a rank from 0 to size - 1
+// the table is only used if it was built for these settings
+size_t SelectionSampler::Draw(SelectionType type, size_t size, double gamma, Random *random) const
+{
+    if (size < 2) return 0;
+    if (type == UniformSelection) return size_t(random->RandomInt(0, int(size) - 1));
+    double u = random->RandomDouble(0.0, 1.0);
+    if (!IsBuilt(type, size, gamma)) return InverseCDF(type, size, gamma, u);
+
+    // one uniform number chooses the column and the remainder chooses between the column and its alias
+    double x = u * double(size);
+    size_t column = size_t(x);
+    if (column >= size) column = size - 1;
+    if (x - double(column) < m_Probability[column]) return column;
+    return m_Alias[column];
+}
+
+size_t SelectionSampler::InverseCDF(SelectionType type, size_t size, double gamma, double u)
+{
+    double n = double(size);
+    double v = 0;
+    switch (type)
+    {
+    case UniformSelection:
+        v = u * n;
+        break;
+    case RankBasedSelection:
+    {
+        // the cumulative weight up to rank r is (r + 1)(r + 2) / 2 so solve the quadratic
+        double x = u * n * (n + 1.0) / 2.0;
+        v = (std::sqrt(1.0 + 8.0 * x) - 1.0) / 2.0;
+        break;
+    }
+    case SqrtBasedSelection:
+        v = std::sqrt(u) * n;
+        break;
+    case GammaBasedSelection:
+        v = std::pow(u, gamma) * n;
+        break;
+    }
+    size_t rank = size_t(v);
+    if (rank >= size) rank = size - 1; // only if u was 1 or rounding errors
+    return rank;
+}
@@ -0,0 +1,58 @@
+/*
+ *  SelectionSampler.h
+ *  AsynchronousGA
+ *
+ *  Created by Bill Sellers on 19/10/2026.
+ *  Copyright 2026 Bill Sellers. All rights reserved.
+ *
+ */
+
+#ifndef SELECTIONSAMPLER_H
+#define SELECTIONSAMPLER_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+class Random;
+
+enum SelectionType
+{
+    UniformSelection,
+    RankBasedSelection,
+    SqrtBasedSelection,
+    GammaBasedSelection
+};
+
+// Chooses a rank from 0 (worst) to size - 1 (best) with the bias given by the
+// selection type. Build precomputes a Walker/Vose alias table so that a draw from
+// a population of that size takes one random number and no searching. Draws for
+// other sizes use the inverse of the cumulative distribution which is still O(1)
+// but needs a sqrt or pow. The sampler is not changed by Draw so one sampler can
+// be shared by several threads as long as they each have their own Random.
+class SelectionSampler
+{
+public:
+    SelectionSampler();
+
+    void Build(SelectionType type, size_t size, double gamma);
+    size_t Draw(SelectionType type, size_t size, double gamma, Random *random) const;
+
+    SelectionType GetSelectionType() const { return m_SelectionType; }
+    size_t GetSize() const { return m_Size; }
+    double GetGamma() const { return m_Gamma; }
+    bool IsBuilt(SelectionType type, size_t size, double gamma) const { return m_SelectionType == type && m_Size == size && m_Gamma == gamma; }
+
+    static double Probability(SelectionType type, size_t rank, size_t size, double gamma);
+
+private:
+    static size_t InverseCDF(SelectionType type, size_t size, double gamma, double u);
+
+    SelectionType m_SelectionType = UniformSelection;
+    size_t m_Size = 0;
+    double m_Gamma = 1.0;
+    std::vector<double> m_Probability; // chance of keeping the column rather than using the alias
+    std::vector<uint32_t> m_Alias;
+};
+
+#endif // SELECTIONSAMPLER_H
@@ -22,21 +22,17 @@ void SessionASIO::start()
 
 void SessionASIO::write(const char *data, size_t size)
 {
-    // need to do prepare and commit for streambuf, the asio::async_write does the consume
-    // the input data may need to be mutex locked for this to work
+    // the data is encoded on the calling thread but the queue is only touched on the io_context thread
+    // this allows several messages to be outstanding on one socket without the async_write calls interleaving
     if (!data || !size) return;
-    std::string encoded = encode(data, size);
-    auto view = m_outgoing.prepare(encoded.size());
-    std::memcpy(view.data(), encoded.data(), encoded.size());
-    m_outgoing.commit(encoded.size());
     try
     {
         // note: shared_from_this() is required here to guarantee that the SessionASIO does not vanish before the handler is used (using this on its own causes a crash)
-        asio::async_write(m_socket, m_outgoing, std::bind(&SessionASIO::on_write, shared_from_this(), std::placeholders::_1, std::placeholders::_2));
+        asio::post(m_socket.get_executor(), [self = shared_from_this(), encoded = encode(data, size)]() mutable { self->queueWrite(std::move(encoded)); });
     }
     catch (std::exception& e)
     {
-        std::cerr << __LINE__ << " asio::async_write() " << e.what() << std::endl;
+        std::cerr << __LINE__ << " asio::post() " << e.what() << std::endl;
     }
     catch (...)
     {
@@ -44,6 +40,28 @@ void SessionASIO::write(const char *data, size_t size)
     }
 }
 
+void SessionASIO::queueWrite(std::string &&encoded)
+{
+    m_outgoing.push_back(std::move(encoded));
+    if (m_outgoing.size() == 1) startWrite(); // otherwise on_write will pick it up
+}
+
+void SessionASIO::startWrite()
+{
+    try
+    {
+        asio::async_write(m_socket, asio::buffer(m_outgoing.front()), std::bind(&SessionASIO::on_write, shared_from_this(), std::placeholders::_1, std::placeholders::_2));
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << __LINE__ << " asio::async_write() " << e.what() << std::endl;
+    }
+    catch (...)
+    {
+        std::cerr << "SessionASIO::startWrite() exception caught on line " << __LINE__ << "\n";
+    }
+}
+
 void SessionASIO::read()
 {
     try
@@ -72,6 +90,10 @@ void SessionASIO::on_read(asio::error_code error, std::size_t bytesTransferred)
         dispatch(str);
         read();
     }
+    else
+    {
+        m_open = false;
+    }
 }
 
 void SessionASIO::on_write(asio::error_code error, std::size_t bytesTransferred)
@@ -79,6 +101,13 @@ void SessionASIO::on_write(asio::error_code error, std::size_t bytesTransferred)
     if (!error)
     {
         m_totalBytesSent += bytesTransferred;
+        m_outgoing.pop_front();
+        if (m_outgoing.size()) startWrite();
+    }
+    else
+    {
+        m_open = false;
+        m_outgoing.clear();
     }
 }
 
@@ -92,8 +121,8 @@ void SessionASIO::dispatch(std::string const& line)
         auto const& entry = it->second;
         MessageASIO message;
         message.session = shared_from_this();
-        message.content = decodedLine;
-        entry(message);
+        message.content = std::move(decodedLine);
+        entry(std::move(message));
     }
 }
 
@@ -225,6 +254,49 @@ void ServerASIO::attach(const std::string &command, std::function<void (MessageA
     m_dispatcher.emplace(command, std::move(function));
 }
 
+// messages arriving on outgoing connections are only looked up here
+// so that an incoming session cannot send something that should only come from the other end
+void ServerASIO::attachOutgoing(const std::string &command, std::function<void (MessageASIO)> &&function)
+{
+    m_outgoingDispatcher.emplace(command, std::move(function));
+}
+
+// opens an outgoing connection that uses the same message framing as the incoming sessions
+// the handler is called on the io_context thread with nullptr if the connection failed
+void ServerASIO::asyncConnect(const std::string &host, std::uint16_t port, std::function<void (std::shared_ptr<SessionASIO>)> &&handler)
+{
+    auto resolver = std::make_shared<asio::ip::tcp::resolver>(m_ioContext);
+    auto socket = std::make_shared<asio::ip::tcp::socket>(m_ioContext);
+    resolver->async_resolve(host, std::to_string(port), [this, resolver, socket, handler = std::move(handler)](const asio::error_code &error, asio::ip::tcp::resolver::results_type results) mutable
+    {
+        if (error)
+        {
+            std::cerr << __LINE__ << " " << error.message() << std::endl;
+            handler(nullptr);
+            return;
+        }
+        asio::async_connect(*socket, results, [this, socket, handler = std::move(handler)](const asio::error_code &error, const asio::ip::tcp::endpoint &) mutable
+        {
+            if (error)
+            {
+                std::cerr << __LINE__ << " " << error.message() << std::endl;
+                handler(nullptr);
+                return;
+            }
+            m_sessionID++;
+            auto session = std::make_shared<SessionASIO>(std::move(*socket), &m_outgoingDispatcher, m_sessionID);
+            session->start();
+            handler(session);
+        });
+    });
+}
+
+// runs the function on the io_context thread
+void ServerASIO::post(std::function<void ()> &&function)
+{
+    asio::post(m_ioContext, std::move(function));
+}
+
 void ServerASIO::accept()
 {
     if (!m_acceptor.has_value())
@@ -10,6 +10,8 @@
 #include <functional>
 #include <optional>
 #include <thread>
+#include <deque>
+#include <atomic>
 
 class SessionASIO;
 
@@ -26,9 +28,12 @@ public:
 
     void start();
     void write(const char *data, size_t size);
+    bool isOpen() const { return m_open; }
 
 private:
     void read();
+    void queueWrite(std::string &&encoded);
+    void startWrite();
     void on_read(asio::error_code error, std::size_t bytesTransferred);
     void on_write(asio::error_code error, std::size_t bytesTransferred);
     void dispatch(const std::string &line);
@@ -39,8 +44,9 @@ private:
     asio::ip::tcp::socket m_socket;
     std::map<std::string, std::function<void (MessageASIO)> > *m_dispatcher;
     asio::streambuf m_incoming;
-    asio::streambuf m_outgoing;
+    std::deque<std::string> m_outgoing; // only accessed on the io_context thread
 
+    std::atomic<bool> m_open = {true};
     uint64_t m_sessionID = 0;
     size_t m_totalBytesSent = 0;
     size_t m_totalBytesReceived = 0;
@@ -56,6 +62,9 @@ public:
     void start();
     void stop();
     void attach(const std::string &command, std::function<void (MessageASIO)> &&function);
+    void attachOutgoing(const std::string &command, std::function<void (MessageASIO)> &&function);
+    void asyncConnect(const std::string &host, std::uint16_t port, std::function<void (std::shared_ptr<SessionASIO>)> &&handler);
+    void post(std::function<void ()> &&function);
 
     void getLocalAddress(std::array<uint8_t, 4> *ipAddress, uint16_t *port);
 
@@ -68,6 +77,7 @@ private:
     std::optional<asio::ip::tcp::tcp::acceptor> m_acceptor;
     std::optional<asio::ip::tcp::tcp::socket> m_socket;
     std::map<std::string, std::function<void (MessageASIO)> > m_dispatcher;
+    std::map<std::string, std::function<void (MessageASIO)> > m_outgoingDispatcher; // only for sessions opened with asyncConnect
 
     static uint64_t m_sessionID;
 };
@@ -11,50 +11,35 @@
 #include <assert.h>
 #include <iostream>
 #include <math.h>
+#include <cmath>
 #include <float.h>
 #include <iomanip>
+#include <cstring>
+#include <cstdint>
 
 #include "Statistics.h"
 #include "Genome.h"
 #include "Population.h"
 
 // calculate standard statistics
+// the population keeps the mean and sd up to date so this is normally O(log n)
+// the mean and sd leave out fitnesses that are out of range (such as the -DBL_MAX of an unscored genome)
+// but min and max are the real ends of the population
 void CalculateStatistics(Population *thePopulation, Statistics *stats)
 {
-    int i;
-    double min = DBL_MAX;
-    double max = -DBL_MAX;
-    double sum = 0;
-    double sumSquareDiff = 0;
-    double variance;
-    double mean;
-    double fitness;
-    double diff;
-    double sd;
-    int populationSize = thePopulation->GetPopulationSize();
-
-    for (i = 0; i < populationSize; i++)
+    const PopulationStats *populationStats = thePopulation->GetPopulationStats();
+    if (thePopulation->GetPopulationSize() == 0)
     {
-        fitness = thePopulation->GetGenome(i)->GetFitness();
-        if (fitness > max) max = fitness;
-        if (fitness < min) min = fitness;
-        sum += fitness;
+        stats->min = 0;
+        stats->max = 0;
+        stats->mean = 0;
+        stats->sd = 0;
+        return;
     }
-
-    mean = sum / populationSize;
-    for (i = 0; i < populationSize; i++)
-    {
-        fitness = thePopulation->GetGenome(i)->GetFitness();
-        diff = fitness - mean;
-        sumSquareDiff += diff * diff;
-    }
-    variance = sumSquareDiff / populationSize;
-    sd = sqrt(variance);
-
-    stats->min = min;
-    stats->max = max;
-    stats->mean = mean;
-    stats->sd = sd;
+    stats->min = thePopulation->GetFitness(0);
+    stats->max = thePopulation->GetLastFitness();
+    stats->mean = populationStats->GetMean();
+    stats->sd = populationStats->GetSD();
 }
 
 // output to a stream
@@ -65,7 +50,7 @@ std::ostream& operator<<(std::ostream &out, Statistics &s)
 }
 
 // calculate percentiles at 10% intervals
-// ASSUMES POPULATION IS SORTED!
+// the population is sorted and indexable by rank so this is 11 O(log n) lookups
 void CalculateTenPercentiles(Population *thePopulation, TenPercentiles *perc)
 {
     double delta = double(thePopulation->GetPopulationSize()) / 10.0;
@@ -76,11 +61,70 @@ void CalculateTenPercentiles(Population *thePopulation, TenPercentiles *perc)
     {
         j = int(index + 0.5);
         if (j >= thePopulation->GetPopulationSize()) j = thePopulation->GetPopulationSize() - 1;
-        perc->values[i] = thePopulation->GetGenome(j)->GetFitness();
+        perc->values[i] = thePopulation->GetFitness(j);
         index += delta;
     }
 }
 
+namespace
+{
+
+// true if the value is finite and small enough that squaring differences cannot overflow
+// checked on the exponent bits because -ffast-math lets the compiler assume std::isfinite is always true
+bool InStatisticsRange(double value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return ((bits >> 52) & 0x7ff) < 1023 + 332; // |value| < 2^332 (about 1e100)
+}
+
+}
+
+void PopulationStats::Add(double fitness)
+{
+    if (!InStatisticsRange(fitness)) return;
+    m_Count++;
+    double delta = fitness - m_Mean;
+    m_Mean += delta / double(m_Count);
+    m_M2 += delta * (fitness - m_Mean);
+}
+
+// the removal update loses precision as genomes come and go so the values are marked for an
+// exact recalculation if most of m_M2 cancels (an outlier leaving) or once as many genomes
+// have been removed as are in the population
+void PopulationStats::Remove(double fitness)
+{
+    if (!InStatisticsRange(fitness)) return;
+    if (m_Count <= 1)
+    {
+        Clear();
+        return;
+    }
+    double oldMean = m_Mean;
+    m_Count--;
+    m_Mean = oldMean - (fitness - oldMean) / double(m_Count);
+    double term = (fitness - oldMean) * (fitness - m_Mean);
+    m_M2 -= term;
+    if (m_M2 < 0) m_M2 = 0; // rounding errors
+    if (term > m_M2 * 1024.0 || ++m_Removals > m_Count) m_Valid = false;
+}
+
+void PopulationStats::Clear()
+{
+    m_Count = 0;
+    m_Mean = 0;
+    m_M2 = 0;
+    m_Removals = 0;
+    m_Valid = true;
+}
+
+// population standard deviation to match CalculateStatistics
+double PopulationStats::GetSD() const
+{
+    if (m_Count == 0) return 0;
+    return std::sqrt(m_M2 / double(m_Count));
+}
+
 // output to a stream
 std::ostream& operator<<(std::ostream &out, TenPercentiles &s)
 {
@@ -11,6 +11,7 @@
 #define STATISTICS_H
 
 #include <iostream>
+#include <cstddef>
 
 class Genome;
 class Population;
@@ -28,6 +29,32 @@ struct TenPercentiles
     double values[11];
 };
 
+// Running mean and standard deviation of the fitnesses in a population. Genomes
+// are added and removed as the population changes so getting the values is O(1).
+// Uses Welford's method. A fitness that is not finite or too large to square safely
+// is left out of the mean and sd and is not included in GetCount. IsValid returns
+// false until Clear is called once the removals may have lost precision, so that the
+// owner can recalculate the values exactly.
+class PopulationStats
+{
+public:
+    void Add(double fitness);
+    void Remove(double fitness);
+    void Clear();
+
+    size_t GetCount() const { return m_Count; }
+    double GetMean() const { return m_Mean; }
+    double GetSD() const;
+    bool IsValid() const { return m_Valid; }
+
+private:
+    size_t m_Count = 0;
+    double m_Mean = 0;
+    double m_M2 = 0; // sum of squared differences from the mean
+    size_t m_Removals = 0;
+    bool m_Valid = true;
+};
+
 void CalculateStatistics(Population *thePopulation, Statistics *stats);
 void CalculateTenPercentiles(Population *thePopulation, TenPercentiles *perc);
 std::ostream& operator<<(std::ostream &out, Statistics &s);
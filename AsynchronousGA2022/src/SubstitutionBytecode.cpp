@@ -0,0 +1,436 @@
+/*
+ *  SubstitutionBytecode.cpp
+ *  AsynchronousGA
+ *
+ *  Created by Bill Sellers on 19/10/2026.
+ *  Copyright 2026 Bill Sellers. All rights reserved.
+ *
+ */
+
+#include "SubstitutionBytecode.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+
+namespace
+{
+
+// the functions are the same as the exprtk definitions
+double AbsFunction(double v) { return (v < 0.0) ? -v : v; }
+double MinFunction(double a, double b) { return std::min<double>(a, b); }
+double MaxFunction(double a, double b) { return std::max<double>(a, b); }
+
+struct Function1 { const char *name; double (*function)(double); };
+const Function1 kFunctions1[] =
+{
+    {"sin", [](double v) { return std::sin(v); }},
+    {"cos", [](double v) { return std::cos(v); }},
+    {"tan", [](double v) { return std::tan(v); }},
+    {"asin", [](double v) { return std::asin(v); }},
+    {"acos", [](double v) { return std::acos(v); }},
+    {"atan", [](double v) { return std::atan(v); }},
+    {"sinh", [](double v) { return std::sinh(v); }},
+    {"cosh", [](double v) { return std::cosh(v); }},
+    {"tanh", [](double v) { return std::tanh(v); }},
+    {"exp", [](double v) { return std::exp(v); }},
+    {"log", [](double v) { return std::log(v); }},
+    {"log10", [](double v) { return std::log10(v); }},
+    {"floor", [](double v) { return std::floor(v); }},
+    {"ceil", [](double v) { return std::ceil(v); }},
+};
+
+struct Function2 { const char *name; double (*function)(double, double); };
+const Function2 kFunctions2[] =
+{
+    {"pow", [](double a, double b) { return std::pow(a, b); }},
+    {"atan2", [](double a, double b) { return std::atan2(a, b); }},
+};
+
+}
+
+// recursive descent over the expression text that emits the instructions as it goes
+// constant subexpressions are folded and never reach the bytecode
+class SubstitutionBytecode::Parser
+{
+public:
+    Parser(SubstitutionBytecode *bytecode, const std::string &text, size_t genomeSize, ConstantConverter converter)
+        : m_Bytecode(bytecode), m_Text(text), m_GenomeSize(genomeSize), m_Converter(converter) {}
+
+    bool Parse(Operand *result)
+    {
+        Next();
+        *result = Expression();
+        return m_OK && m_Token == End;
+    }
+
+private:
+    enum TokenType { End, Number, Name, Character };
+
+    void Next()
+    {
+        while (m_Position < m_Text.size() && m_Text[m_Position] < 33) m_Position++;
+        m_TokenText.clear();
+        if (m_Position >= m_Text.size()) { m_Token = End; return; }
+        unsigned char c = static_cast<unsigned char>(m_Text[m_Position]);
+        if (isdigit(c) || c == '.')
+        {
+            size_t start = m_Position;
+            while (m_Position < m_Text.size() && (isdigit(static_cast<unsigned char>(m_Text[m_Position])) || m_Text[m_Position] == '.')) m_Position++;
+            if (m_Position < m_Text.size() && (m_Text[m_Position] == 'e' || m_Text[m_Position] == 'E'))
+            {
+                m_Position++;
+                if (m_Position < m_Text.size() && (m_Text[m_Position] == '+' || m_Text[m_Position] == '-')) m_Position++;
+                while (m_Position < m_Text.size() && isdigit(static_cast<unsigned char>(m_Text[m_Position]))) m_Position++;
+            }
+            if (m_Position < m_Text.size() && (isalpha(static_cast<unsigned char>(m_Text[m_Position])) || m_Text[m_Position] == '_')) m_OK = false; // e.g. 2x which exprtk treats as 2*x
+            m_TokenText = m_Text.substr(start, m_Position - start);
+            m_Token = Number;
+            return;
+        }
+        if (isalpha(c) || c == '_')
+        {
+            // exprtk names are not case sensitive
+            while (m_Position < m_Text.size() && (isalnum(static_cast<unsigned char>(m_Text[m_Position])) || m_Text[m_Position] == '_'))
+                m_TokenText.push_back(char(tolower(static_cast<unsigned char>(m_Text[m_Position++]))));
+            m_Token = Name;
+            return;
+        }
+        m_TokenText.push_back(char(c));
+        m_Position++;
+        m_Token = Character;
+    }
+
+    bool Accept(char c)
+    {
+        if (m_Token != Character || m_TokenText[0] != c) return false;
+        Next();
+        return true;
+    }
+
+    void Expect(char c)
+    {
+        if (!Accept(c)) m_OK = false;
+    }
+
+    Operand Fail()
+    {
+        m_OK = false;
+        return Operand{true, 0, 0};
+    }
+
+    // exprtk rewrites operations with a zero constant (0*x, x/0, 0-x etc.) in ways that do not
+    // keep the sign of zero or nan so those are left to exprtk
+    bool ZeroConstant(const Operand &a, const Operand &b)
+    {
+        return (a.isConstant && a.value == 0) || (b.isConstant && b.value == 0);
+    }
+
+    Operand Expression()
+    {
+        Operand left = Term();
+        while (m_OK)
+        {
+            Opcode op;
+            if (Accept('+')) op = Add;
+            else if (Accept('-')) op = Subtract;
+            else break;
+            Operand right = Term();
+            if (!m_OK) break;
+            if (ZeroConstant(left, right) && !(left.isConstant && right.isConstant)) return Fail();
+            left = m_Bytecode->EmitBinary(op, left, right);
+        }
+        return left;
+    }
+
+    Operand Term()
+    {
+        Operand left = Unary();
+        while (m_OK)
+        {
+            Opcode op;
+            if (Accept('*')) op = Multiply;
+            else if (Accept('/')) op = Divide;
+            else break;
+            Operand right = Unary();
+            if (!m_OK) break;
+            if (ZeroConstant(left, right) && !(left.isConstant && right.isConstant)) return Fail();
+            left = m_Bytecode->EmitBinary(op, left, right);
+        }
+        return left;
+    }
+
+    Operand Unary()
+    {
+        if (Accept('-'))
+        {
+            Operand operand = Unary();
+            if (!m_OK) return operand;
+            return m_Bytecode->EmitUnary(Negate, 0, operand);
+        }
+        if (Accept('+')) return Unary();
+        return Primary();
+    }
+
+    Operand Primary()
+    {
+        if (m_Token == Number)
+        {
+            Operand operand{true, 0, 0};
+            if (!m_Converter(m_TokenText, &operand.value)) return Fail();
+            Next();
+            return operand;
+        }
+        if (Accept('('))
+        {
+            Operand operand = Expression();
+            Expect(')');
+            return operand;
+        }
+        if (m_Token != Name) return Fail();
+        std::string name = m_TokenText;
+        Next();
+        if (name == "g")
+        {
+            Expect('[');
+            if (!m_OK || m_Token != Number || m_TokenText.size() > 9 || m_TokenText.find_first_not_of("0123456789") != std::string::npos) return Fail();
+            size_t locus = size_t(std::stoul(m_TokenText));
+            if (locus >= m_GenomeSize) return Fail(); // left to exprtk
+            Next();
+            Expect(']');
+            if (!m_OK) return Fail();
+            Operand operand{false, 0, m_Bytecode->AllocateRegister()};
+            m_Bytecode->m_Instructions.push_back({LoadGene, operand.reg, 0, 0, locus, 0});
+            return operand;
+        }
+        if (!Accept('('))
+        {
+            // named constants such as pi
+            Operand operand{true, 0, 0};
+            if (!m_Converter(name, &operand.value)) return Fail();
+            return operand;
+        }
+        std::vector<Operand> arguments;
+        do
+        {
+            arguments.push_back(Expression());
+        }
+        while (m_OK && Accept(','));
+        Expect(')');
+        if (!m_OK) return Fail();
+        if (arguments.size() == 1)
+        {
+            if (name == "abs") return m_Bytecode->EmitUnary(Abs, 0, arguments[0]);
+            if (name == "sqrt") return m_Bytecode->EmitUnary(Sqrt, 0, arguments[0]);
+            for (size_t i = 0; i < sizeof(kFunctions1) / sizeof(kFunctions1[0]); i++)
+                if (name == kFunctions1[i].name) return m_Bytecode->EmitUnary(Call1, i, arguments[0]);
+        }
+        if (arguments.size() == 2)
+        {
+            if (name == "min") return m_Bytecode->EmitBinary(Min, arguments[0], arguments[1]);
+            if (name == "max") return m_Bytecode->EmitBinary(Max, arguments[0], arguments[1]);
+            for (size_t i = 0; i < sizeof(kFunctions2) / sizeof(kFunctions2[0]); i++)
+            {
+                if (name != kFunctions2[i].name) continue;
+                Operand operand = m_Bytecode->EmitBinary(Call2, arguments[0], arguments[1]);
+                if (!operand.isConstant) m_Bytecode->m_Instructions.back().index = i;
+                else operand.value = kFunctions2[i].function(arguments[0].value, arguments[1].value);
+                return operand;
+            }
+        }
+        return Fail();
+    }
+
+    SubstitutionBytecode *m_Bytecode;
+    const std::string &m_Text;
+    size_t m_GenomeSize;
+    ConstantConverter m_Converter;
+    size_t m_Position = 0;
+    TokenType m_Token = End;
+    std::string m_TokenText;
+    bool m_OK = true;
+};
+
+void SubstitutionBytecode::Clear()
+{
+    m_Instructions.clear();
+    m_NextRegister = 0;
+    m_NumRegisters = 0;
+}
+
+void SubstitutionBytecode::AddConstant(double value, size_t output)
+{
+    EmitStore(Operand{true, value, 0}, output);
+}
+
+void SubstitutionBytecode::AddGene(size_t locus, size_t output)
+{
+    uint32_t reg = AllocateRegister();
+    m_Instructions.push_back({LoadGene, reg, 0, 0, locus, 0});
+    EmitStore(Operand{false, 0, reg}, output);
+}
+
+// the same operations as the affine substitutions in XMLConverter::ApplyGenome
+void SubstitutionBytecode::AddAffine(size_t locus, double scale, double offset, bool divide, size_t output)
+{
+    uint32_t reg = AllocateRegister();
+    m_Instructions.push_back({LoadGene, reg, 0, 0, locus, 0});
+    Operand operand = EmitBinary(divide ? Divide : Multiply, Operand{false, 0, reg}, Operand{true, scale, 0});
+    operand = EmitBinary(Add, operand, Operand{true, offset, 0});
+    EmitStore(operand, output);
+}
+
+bool SubstitutionBytecode::AddExpression(const std::string &text, size_t genomeSize, ConstantConverter converter, size_t output)
+{
+    size_t numInstructions = m_Instructions.size();
+    uint32_t numRegisters = m_NumRegisters;
+    Operand result;
+    Parser parser(this, text, genomeSize, converter);
+    if (!parser.Parse(&result))
+    {
+        m_Instructions.resize(numInstructions);
+        m_NextRegister = 0;
+        m_NumRegisters = numRegisters;
+        return false;
+    }
+    EmitStore(result, output);
+    return true;
+}
+
+uint32_t SubstitutionBytecode::AllocateRegister()
+{
+    uint32_t reg = m_NextRegister++;
+    m_NumRegisters = std::max(m_NumRegisters, m_NextRegister);
+    return reg;
+}
+
+uint32_t SubstitutionBytecode::Materialise(const Operand &operand)
+{
+    if (!operand.isConstant) return operand.reg;
+    uint32_t reg = AllocateRegister();
+    m_Instructions.push_back({LoadConstant, reg, 0, 0, 0, operand.value});
+    return reg;
+}
+
+// the result goes in the lower of the two registers and the other one is released
+// operands are always the top of the register stack so this keeps it a stack
+SubstitutionBytecode::Operand SubstitutionBytecode::EmitBinary(Opcode op, const Operand &a, const Operand &b)
+{
+    if (a.isConstant && b.isConstant)
+    {
+        switch (op)
+        {
+        case Add: return Operand{true, a.value + b.value, 0};
+        case Subtract: return Operand{true, a.value - b.value, 0};
+        case Multiply: return Operand{true, a.value * b.value, 0};
+        case Divide: return Operand{true, a.value / b.value, 0};
+        case Min: return Operand{true, MinFunction(a.value, b.value), 0};
+        case Max: return Operand{true, MaxFunction(a.value, b.value), 0};
+        default: return Operand{true, 0, 0}; // Call2 is folded by the caller
+        }
+    }
+    uint32_t regA = Materialise(a);
+    uint32_t regB = Materialise(b);
+    uint32_t dst = std::min(regA, regB);
+    m_Instructions.push_back({op, dst, regA, regB, 0, 0});
+    m_NextRegister = dst + 1;
+    return Operand{false, 0, dst};
+}
+
+SubstitutionBytecode::Operand SubstitutionBytecode::EmitUnary(Opcode op, size_t function, const Operand &a)
+{
+    if (a.isConstant)
+    {
+        switch (op)
+        {
+        case Negate: return Operand{true, -a.value, 0};
+        case Abs: return Operand{true, AbsFunction(a.value), 0};
+        case Sqrt: return Operand{true, std::sqrt(a.value), 0};
+        default: return Operand{true, kFunctions1[function].function(a.value), 0};
+        }
+    }
+    m_Instructions.push_back({op, a.reg, a.reg, 0, function, 0});
+    return a;
+}
+
+void SubstitutionBytecode::EmitStore(const Operand &operand, size_t output)
+{
+    uint32_t reg = Materialise(operand);
+    m_Instructions.push_back({Store, 0, reg, 0, output, 0});
+    m_NextRegister = 0;
+}
+
+// the genomes are done kLanes at a time so the registers stay in the cache
+void SubstitutionBytecode::Evaluate(size_t numLanes, const double *genes, size_t geneStride, double *values, size_t valueStride)
+{
+    size_t registerFileSize = std::max(m_NumRegisters, uint32_t(1)) * kLanes;
+    if (m_RegisterFile.size() < registerFileSize) m_RegisterFile.resize(registerFileSize);
+    double *registers = m_RegisterFile.data();
+    for (size_t base = 0; base < numLanes; base += kLanes)
+    {
+        size_t n = std::min(kLanes, numLanes - base);
+        for (auto &&instruction : m_Instructions)
+        {
+            double *dst = registers + instruction.dst * kLanes;
+            const double *a = registers + instruction.a * kLanes;
+            const double *b = registers + instruction.b * kLanes;
+            switch (instruction.op)
+            {
+            case LoadConstant:
+                for (size_t j = 0; j < n; j++) dst[j] = instruction.constant;
+                break;
+            case LoadGene:
+            {
+                const double *src = genes + instruction.index * geneStride + base;
+                for (size_t j = 0; j < n; j++) dst[j] = src[j];
+                break;
+            }
+            case Store:
+            {
+                double *out = values + instruction.index * valueStride + base;
+                for (size_t j = 0; j < n; j++) out[j] = a[j];
+                break;
+            }
+            case Add:
+                for (size_t j = 0; j < n; j++) dst[j] = a[j] + b[j];
+                break;
+            case Subtract:
+                for (size_t j = 0; j < n; j++) dst[j] = a[j] - b[j];
+                break;
+            case Multiply:
+                for (size_t j = 0; j < n; j++) dst[j] = a[j] * b[j];
+                break;
+            case Divide:
+                for (size_t j = 0; j < n; j++) dst[j] = a[j] / b[j];
+                break;
+            case Negate:
+                for (size_t j = 0; j < n; j++) dst[j] = -a[j];
+                break;
+            case Abs:
+                for (size_t j = 0; j < n; j++) dst[j] = AbsFunction(a[j]);
+                break;
+            case Sqrt:
+                for (size_t j = 0; j < n; j++) dst[j] = std::sqrt(a[j]);
+                break;
+            case Min:
+                for (size_t j = 0; j < n; j++) dst[j] = MinFunction(a[j], b[j]);
+                break;
+            case Max:
+                for (size_t j = 0; j < n; j++) dst[j] = MaxFunction(a[j], b[j]);
+                break;
+            case Call1:
+            {
+                double (*function)(double) = kFunctions1[instruction.index].function;
+                for (size_t j = 0; j < n; j++) dst[j] = function(a[j]);
+                break;
+            }
+            case Call2:
+            {
+                double (*function)(double, double) = kFunctions2[instruction.index].function;
+                for (size_t j = 0; j < n; j++) dst[j] = function(a[j], b[j]);
+                break;
+            }
+            }
+        }
+    }
+}
@@ -0,0 +1,82 @@
+/*
+ *  SubstitutionBytecode.h
+ *  AsynchronousGA
+ *
+ *  Created by Bill Sellers on 19/10/2026.
+ *  Copyright 2026 Bill Sellers. All rights reserved.
+ *
+ */
+
+#ifndef SUBSTITUTIONBYTECODE_H
+#define SUBSTITUTIONBYTECODE_H
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// A small register machine for the [[...]] substitutions that evaluates many genomes at once.
+// Each register holds one value for each of kLanes genomes so every instruction is a short
+// loop across genomes that the compiler can vectorise. The genes are read in structure of arrays
+// form (gene locus of genome j is genes[locus * geneStride + j]) and each substitution result is
+// written the same way (values[output * valueStride + j]).
+// Only arithmetic (+ - * /), literal g[n], the common exprtk functions and constants are lowered.
+// Anything else is rejected so that the caller can leave it to exprtk. The operations are done in
+// the order they are written so the results can differ from exprtk in the last bit where exprtk
+// regroups constants.
+class SubstitutionBytecode
+{
+public:
+    static constexpr size_t kLanes = 32;
+
+    // converts numeric literals and named constants such as pi
+    typedef bool (*ConstantConverter)(const std::string &text, double *value);
+
+    void Clear();
+
+    void AddConstant(double value, size_t output);
+    void AddGene(size_t locus, size_t output);
+    void AddAffine(size_t locus, double scale, double offset, bool divide, size_t output);
+    // returns false and adds nothing if the expression cannot be lowered
+    bool AddExpression(const std::string &text, size_t genomeSize, ConstantConverter converter, size_t output);
+
+    void Evaluate(size_t numLanes, const double *genes, size_t geneStride, double *values, size_t valueStride);
+
+    size_t GetNumInstructions() const { return m_Instructions.size(); }
+    size_t GetNumRegisters() const { return m_NumRegisters; }
+
+private:
+    enum Opcode : uint8_t { LoadConstant, LoadGene, Store, Add, Subtract, Multiply, Divide, Negate, Abs, Sqrt, Min, Max, Call1, Call2 };
+    struct Instruction
+    {
+        Opcode op;
+        uint32_t dst;
+        uint32_t a;
+        uint32_t b;
+        size_t index; // locus for LoadGene, output for Store and the function for Call1 and Call2
+        double constant;
+    };
+
+    // an operand is either a constant that has not been put into a register yet or a register
+    struct Operand
+    {
+        bool isConstant;
+        double value;
+        uint32_t reg;
+    };
+
+    class Parser;
+
+    uint32_t AllocateRegister();
+    uint32_t Materialise(const Operand &operand);
+    Operand EmitBinary(Opcode op, const Operand &a, const Operand &b);
+    Operand EmitUnary(Opcode op, size_t function, const Operand &a);
+    void EmitStore(const Operand &operand, size_t output);
+
+    std::vector<Instruction> m_Instructions;
+    uint32_t m_NextRegister = 0; // registers are used as a stack while an expression is lowered
+    uint32_t m_NumRegisters = 0;
+    std::vector<double> m_RegisterFile; // kept between calls so that Evaluate does not allocate
+};
+
+#endif // SUBSTITUTIONBYTECODE_H
@@ -9,46 +9,169 @@
 
 #include "XMLConverter.h"
 #include "DataFile.h"
+#include "SubstitutionBytecode.h"
 
 #include "exprtk.hpp"
 
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
-#include <sstream>
+#include <errno.h>
 #include <cfloat>
 #include <cmath>
 #include <assert.h>
 #include <iostream>
-#include <sstream>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+
+#if defined(_WIN32) || defined(WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// the expressions are compiled once against a view of the genome and the view is
+// pointed at the new genome data before each evaluation
+// the direct and affine substitutions are listed here too because which ones can be
+// done natively depends on the genome size
+struct XMLConverter::CompiledExpressions
+{
+    struct DirectEntry { size_t valueIndex; size_t locus; };
+    struct AffineEntry { size_t valueIndex; size_t locus; double scale; double offset; };
+
+    CompiledExpressions(size_t genomeSize) : dummyGenome(genomeSize, 0.0), genomeView(dummyGenome.data(), genomeSize) {}
+    std::vector<double> dummyGenome;
+    exprtk::vector_view<double> genomeView;
+    exprtk::symbol_table<double> symbolTable;
+    std::vector<exprtk::expression<double>> expressions;
+    std::vector<size_t> expressionValueIndices;
+    std::vector<size_t> substitutionExpressionIndices; // npos if the substitution does not use exprtk
+    std::vector<std::vector<size_t>> geneDependents; // the substitutions that read each locus
+    std::vector<size_t> allGeneDependents; // the substitutions that may read any locus
+    std::vector<DirectEntry> directEntries;
+    std::vector<AffineEntry> multiplyEntries;
+    std::vector<AffineEntry> divideEntries;
+
+    // for ApplyGenomes everything that can be lowered goes into the bytecode and the rest is done by exprtk genome by genome
+    struct BatchEntry { size_t valueIndex; size_t expressionIndex; };
+    SubstitutionBytecode bytecode;
+    std::vector<BatchEntry> batchEntries;
+    std::vector<double> batchGenome; // the genome being done by exprtk, kept between calls
+};
+
+namespace
+{
+
+// the tokens needed to recognise the simple substitutions
+// anything else means the expression is left to exprtk
+struct SubstitutionToken
+{
+    char type; // 'n' for a number, otherwise the character itself
+    std::string text;
+};
+
+bool TokeniseSubstitution(const std::string &text, std::vector<SubstitutionToken> *tokens)
+{
+    tokens->clear();
+    size_t i = 0;
+    while (i < text.size())
+    {
+        char c = text[i];
+        if (c < 33) { i++; continue; }
+        if (c == 'g' || c == '[' || c == ']' || c == '*' || c == '/' || c == '+' || c == '-')
+        {
+            tokens->push_back({c, std::string(1, c)});
+            i++;
+            if (c == 'g' && i < text.size() && (isalnum(static_cast<unsigned char>(text[i])) || text[i] == '_')) return false; // part of a longer name
+            continue;
+        }
+        if (isdigit(static_cast<unsigned char>(c)) || c == '.')
+        {
+            size_t start = i;
+            while (i < text.size() && (isdigit(static_cast<unsigned char>(text[i])) || text[i] == '.')) i++;
+            if (i < text.size() && (text[i] == 'e' || text[i] == 'E'))
+            {
+                i++;
+                if (i < text.size() && (text[i] == '+' || text[i] == '-')) i++;
+                while (i < text.size() && isdigit(static_cast<unsigned char>(text[i]))) i++;
+            }
+            if (i < text.size() && (isalpha(static_cast<unsigned char>(text[i])) || text[i] == '_')) return false; // e.g. 2x which exprtk treats as 2*x
+            tokens->push_back({'n', text.substr(start, i - start)});
+            continue;
+        }
+        return false;
+    }
+    return true;
+}
+
+// numbers are converted by exprtk so that the values are exactly what exprtk would have used
+bool EvaluateConstant(const std::string &text, double *value)
+{
+    exprtk::symbol_table<double> symbolTable;
+    symbolTable.add_constants();
+    exprtk::expression<double> expression;
+    expression.register_symbol_table(symbolTable);
+    exprtk::parser<double> parser;
+    if (!parser.compile(text, expression)) return false;
+    *value = expression.value();
+    return true;
+}
+
+// the shortest text that reads back as the same double and is not affected by the locale
+// the longest output is -d.ddddddddddddddddde-ddd
+const size_t kMaxFormattedValueLength = 32;
+
+size_t FormatValue(double value, char *buffer)
+{
+#if defined(__cpp_lib_to_chars)
+    return size_t(std::to_chars(buffer, buffer + kMaxFormattedValueLength, value).ptr - buffer);
+#else
+    int length = snprintf(buffer, kMaxFormattedValueLength, "%.17g", value);
+    return length > 0 ? std::min(size_t(length), kMaxFormattedValueLength - 1) : 0;
+#endif
+}
+
+}
 
 XMLConverter::XMLConverter()
 {
 }
 
+XMLConverter::~XMLConverter()
+{
+}
+
 // load the base file for smart substitution file
 int XMLConverter::LoadBaseXMLFile(const char *filename)
 {
     DataFile smartSubstitutionBaseXMLFile;
     if (smartSubstitutionBaseXMLFile.ReadFile(filename)) return 1;
-    LoadBaseXMLString(smartSubstitutionBaseXMLFile.GetRawData(), smartSubstitutionBaseXMLFile.GetSize());
-    return 0;
+    return LoadBaseXMLString(smartSubstitutionBaseXMLFile.GetRawData(), smartSubstitutionBaseXMLFile.GetSize());
 }
 
 void XMLConverter::Clear()
 {
     m_SmartSubstitutionTextComponents.clear();
+    m_SmartSubstitutionTextLength = 0;
     m_SmartSubstitutionParserText.clear();
     m_SmartSubstitutionValues.clear();
+    m_SmartSubstitutions.clear();
     m_BaseXMLString.clear();
+    m_CompiledExpressions.reset();
+    m_FormattedXMLValid = false;
 }
 
 // load the base XML for smart substitution file
+// returns non-zero and leaves the converter empty if the substitutions are not properly closed
 int XMLConverter::LoadBaseXMLString(const char *dataPtr, size_t length)
 {
     m_SmartSubstitutionTextComponents.clear();
     m_SmartSubstitutionParserText.clear();
     m_SmartSubstitutionValues.clear();
+    m_SmartSubstitutions.clear();
+    m_CompiledExpressions.reset();
+    m_FormattedXMLValid = false;
     m_BaseXMLString = std::string(dataPtr, length);
 
     const char *ptr1 = dataPtr;
@@ -63,7 +186,8 @@ int XMLConverter::LoadBaseXMLString(const char *dataPtr, size_t length)
         if (ptr1 == nullptr)
         {
             std::cerr << "Error: could not find matching ]]\n";
-            exit(1);
+            Clear();
+            return __LINE__;
         }
         std::string expressionParserText(ptr2, static_cast<size_t>(ptr1 - ptr2));
         m_SmartSubstitutionParserText.push_back(std::move(expressionParserText));
@@ -73,60 +197,433 @@ int XMLConverter::LoadBaseXMLString(const char *dataPtr, size_t length)
     }
     std::string s(ptr1);
     m_SmartSubstitutionTextComponents.push_back(std::move(s));
-
+    m_SmartSubstitutionTextLength = 0;
+    for (auto &&component : m_SmartSubstitutionTextComponents) m_SmartSubstitutionTextLength += component.size();
 
     // get the vector brackets in the right format for exprtk if necessary
     ConvertVectorBrackets();
 
+    // find the substitutions that do not need exprtk
+    ClassifyExpressions();
+
+    // and which genes each substitution reads
+    FindDependencies();
+
     return 0;
 }
 
 void XMLConverter::GetFormattedXML(std::string *formattedXML)
 {
-    std::ostringstream ss;
-    ss.precision(17);
-    for (size_t i = 0; i < m_SmartSubstitutionValues.size(); i++)
+    UpdateFormattedXML();
+    *formattedXML = m_FormattedXML;
+}
+
+// returns the length of the XML and only writes it if it fits in the buffer (no terminating zero is added)
+size_t XMLConverter::GetFormattedXML(char *buffer, size_t bufferSize)
+{
+    UpdateFormattedXML();
+    if (m_FormattedXML.size() <= bufferSize) memcpy(buffer, m_FormattedXML.data(), m_FormattedXML.size());
+    return m_FormattedXML.size();
+}
+
+// returns 0 on success
+int XMLConverter::WriteFormattedXML(int fileDescriptor)
+{
+    UpdateFormattedXML();
+    const char *ptr = m_FormattedXML.data();
+    size_t remaining = m_FormattedXML.size();
+    while (remaining)
+    {
+#if defined(_WIN32) || defined(WIN32)
+        int count = _write(fileDescriptor, ptr, unsigned(std::min(remaining, size_t(1) << 30)));
+#else
+        ssize_t count = write(fileDescriptor, ptr, remaining);
+#endif
+        if (count < 0)
+        {
+            if (errno == EINTR) continue;
+            return __LINE__;
+        }
+        ptr += count;
+        remaining -= size_t(count);
+    }
+    return 0;
+}
+
+// after ApplyGenomeChanges only the values that have changed are reformatted
+void XMLConverter::UpdateFormattedXML()
+{
+    char buffer[kMaxFormattedValueLength];
+    size_t numValues = m_SmartSubstitutionValues.size();
+    if (!m_FormattedXMLValid)
+    {
+        // the output is sized for the longest possible values and trimmed afterwards
+        m_FormattedXML.resize(m_SmartSubstitutionTextLength + numValues * kMaxFormattedValueLength);
+        m_FormattedValueOffsets.resize(numValues);
+        m_FormattedValueLengths.resize(numValues);
+        char *start = &m_FormattedXML[0];
+        char *ptr = start;
+        for (size_t i = 0; i < numValues; i++)
+        {
+            const std::string &text = m_SmartSubstitutionTextComponents[i];
+            memcpy(ptr, text.data(), text.size());
+            ptr += text.size();
+            size_t length = FormatValue(m_SmartSubstitutionValues[i], ptr);
+            m_FormattedValueOffsets[i] = size_t(ptr - start);
+            m_FormattedValueLengths[i] = length;
+            ptr += length;
+        }
+        const std::string &text = m_SmartSubstitutionTextComponents[numValues];
+        memcpy(ptr, text.data(), text.size());
+        ptr += text.size();
+        m_FormattedXML.resize(size_t(ptr - start));
+        m_FormattedXMLValid = true;
+        for (auto &&i : m_ChangedSubstitutions) m_SubstitutionChanged[i] = 0;
+        m_ChangedSubstitutions.clear();
+        return;
+    }
+    if (m_ChangedSubstitutions.empty()) return;
+
+    // values with the same length are overwritten in place
+    // otherwise everything after the first value that changes length has to move
+    std::sort(m_ChangedSubstitutions.begin(), m_ChangedSubstitutions.end());
+    size_t firstMoved = numValues;
+    for (auto &&i : m_ChangedSubstitutions)
     {
-        ss << m_SmartSubstitutionTextComponents[i] << m_SmartSubstitutionValues[i];
+        size_t length = FormatValue(m_SmartSubstitutionValues[i], buffer);
+        if (length != m_FormattedValueLengths[i])
+        {
+            if (firstMoved == numValues) firstMoved = i;
+            continue;
+        }
+        memcpy(&m_FormattedXML[m_FormattedValueOffsets[i]], buffer, length);
+        m_SubstitutionChanged[i] = 0;
+    }
+    if (firstMoved < numValues)
+    {
+        // the tail is rebuilt from the old text except for the values that changed length
+        std::string tail;
+        tail.reserve(m_FormattedXML.size() - m_FormattedValueOffsets[firstMoved] + kMaxFormattedValueLength * (m_ChangedSubstitutions.size() + 1));
+        size_t tailOffset = m_FormattedValueOffsets[firstMoved];
+        for (size_t i = firstMoved; i < numValues; i++)
+        {
+            if (i > firstMoved) tail.append(m_SmartSubstitutionTextComponents[i]);
+            size_t newOffset = tailOffset + tail.size();
+            if (m_SubstitutionChanged[i])
+            {
+                size_t length = FormatValue(m_SmartSubstitutionValues[i], buffer);
+                tail.append(buffer, length);
+                m_FormattedValueLengths[i] = length;
+                m_SubstitutionChanged[i] = 0;
+            }
+            else
+            {
+                tail.append(m_FormattedXML, m_FormattedValueOffsets[i], m_FormattedValueLengths[i]);
+            }
+            m_FormattedValueOffsets[i] = newOffset;
+        }
+        tail.append(m_SmartSubstitutionTextComponents[numValues]);
+        m_FormattedXML.resize(tailOffset);
+        m_FormattedXML.append(tail);
     }
-    ss << m_SmartSubstitutionTextComponents[m_SmartSubstitutionValues.size()];
-    *formattedXML = ss.str();
+    m_ChangedSubstitutions.clear();
 }
 
 // this needs to be customised depending on how the genome interacts with
 // the XML file specifying the simulation
 int XMLConverter::ApplyGenome(int genomeSize, double *genomeData)
 {
-    exprtk::symbol_table<double> symbol_table;
-    exprtk::expression<double> expression;
-    exprtk::parser<double> parser;
+    // the size of g is fixed when the expressions are compiled so they are only recompiled if it changes
+    if (!m_CompiledExpressions || m_CompiledExpressions->genomeView.size() != size_t(genomeSize)) CompileExpressions(size_t(genomeSize));
+    CompiledExpressions *compiledExpressions = m_CompiledExpressions.get();
 
-    for (unsigned int i = 0; i < m_SmartSubstitutionParserText.size(); i++)
+    m_FormattedXMLValid = false; // everything may have changed
+
+    double *values = m_SmartSubstitutionValues.data();
+    for (auto &&entry : compiledExpressions->directEntries) values[entry.valueIndex] = genomeData[entry.locus];
+    for (auto &&entry : compiledExpressions->multiplyEntries) values[entry.valueIndex] = genomeData[entry.locus] * entry.scale + entry.offset;
+    for (auto &&entry : compiledExpressions->divideEntries) values[entry.valueIndex] = genomeData[entry.locus] / entry.scale + entry.offset;
+
+    if (compiledExpressions->expressions.size())
     {
-        // set up the genome as a function g(locus) and evaluate
+        compiledExpressions->genomeView.rebase(genomeData);
+        for (size_t i = 0; i < compiledExpressions->expressions.size(); i++)
+            values[compiledExpressions->expressionValueIndices[i]] = compiledExpressions->expressions[i].value();
+    }
+
+    return 0;
+}
+
+// evaluates every substitution for a batch of genomes without changing the current XML
+// gene locus of genome j is genes[locus * geneStride + j] so a single genome can be passed with geneStride 1
+// and substitution i of genome j is written to values[i * valueStride + j]
+int XMLConverter::ApplyGenomes(int genomeSize, size_t numGenomes, const double *genes, size_t geneStride, double *values, size_t valueStride)
+{
+    if (!m_CompiledExpressions || m_CompiledExpressions->genomeView.size() != size_t(genomeSize)) CompileExpressions(size_t(genomeSize));
+    CompiledExpressions *compiledExpressions = m_CompiledExpressions.get();
+
+    compiledExpressions->bytecode.Evaluate(numGenomes, genes, geneStride, values, valueStride);
+
+    if (compiledExpressions->batchEntries.size())
+    {
+        std::vector<double> &genome = compiledExpressions->batchGenome;
+        genome.resize(static_cast<size_t>(genomeSize));
+        compiledExpressions->genomeView.rebase(genome.data());
+        for (size_t j = 0; j < numGenomes; j++)
+        {
+            for (size_t locus = 0; locus < size_t(genomeSize); locus++) genome[locus] = genes[locus * geneStride + j];
+            for (auto &&entry : compiledExpressions->batchEntries)
+                values[entry.valueIndex * valueStride + j] = compiledExpressions->expressions[entry.expressionIndex].value();
+        }
+        compiledExpressions->genomeView.rebase(compiledExpressions->dummyGenome.data());
+    }
+
+    return 0;
+}
+
+size_t XMLConverter::GetNumSubstitutions() const
+{
+    return m_SmartSubstitutionValues.size();
+}
 
-        symbol_table.add_vector("g", genomeData, size_t(genomeSize));
-        symbol_table.add_constants();
+// re-evaluate only the substitutions that read the changed genes
+// the previous genome must have been applied with ApplyGenome or ApplyGenomeChanges
+int XMLConverter::ApplyGenomeChanges(int genomeSize, double *genomeData, const size_t *changedGenes, size_t numChangedGenes)
+{
+    if (!m_CompiledExpressions || m_CompiledExpressions->genomeView.size() != size_t(genomeSize)) return ApplyGenome(genomeSize, genomeData);
+    CompiledExpressions *compiledExpressions = m_CompiledExpressions.get();
+    if (numChangedGenes == 0) return 0;
+
+    compiledExpressions->genomeView.rebase(genomeData);
+    double *values = m_SmartSubstitutionValues.data();
+    auto update = [&](size_t i)
+    {
+        double value = EvaluateSubstitution(i, genomeData);
+        if (memcmp(&value, &values[i], sizeof(double)) == 0) return; // no change to the text
+        values[i] = value;
+        if (m_SubstitutionChanged[i]) return;
+        m_SubstitutionChanged[i] = 1;
+        m_ChangedSubstitutions.push_back(i);
+    };
+    for (size_t i = 0; i < numChangedGenes; i++)
+    {
+        if (changedGenes[i] >= size_t(genomeSize)) continue;
+        for (auto &&substitution : compiledExpressions->geneDependents[changedGenes[i]]) update(substitution);
+    }
+    for (auto &&substitution : compiledExpressions->allGeneDependents) update(substitution);
 
-        expression.register_symbol_table(symbol_table);
+    return 0;
+}
+
+double XMLConverter::EvaluateSubstitution(size_t i, const double *genomeData)
+{
+    size_t expressionIndex = m_CompiledExpressions->substitutionExpressionIndices[i];
+    if (expressionIndex != std::string::npos) return m_CompiledExpressions->expressions[expressionIndex].value();
+    const Substitution &substitution = m_SmartSubstitutions[i];
+    switch (substitution.type)
+    {
+    case DirectSubstitution:
+        return genomeData[substitution.locus];
+    case AffineSubstitution:
+        if (substitution.divide) return genomeData[substitution.locus] / substitution.scale + substitution.offset;
+        return genomeData[substitution.locus] * substitution.scale + substitution.offset;
+    case ConstantSubstitution:
+    case GeneralSubstitution:
+        break;
+    }
+    return m_SmartSubstitutionValues[i]; // constants and expressions that did not compile never change
+}
 
-//        std::cerr << "substitution text " << i << ": " << *m_SmartSubstitutionParserText[i] << "\n";
-        bool success = parser.compile(m_SmartSubstitutionParserText[i], expression);
+// set up the genome as a vector g[locus] and compile the substitutions that need exprtk
+void XMLConverter::CompileExpressions(size_t genomeSize)
+{
+    m_CompiledExpressions = std::make_unique<CompiledExpressions>(genomeSize);
+    CompiledExpressions *compiledExpressions = m_CompiledExpressions.get();
+    compiledExpressions->symbolTable.add_vector("g", compiledExpressions->genomeView);
+    compiledExpressions->symbolTable.add_constants();
+    compiledExpressions->substitutionExpressionIndices.assign(m_SmartSubstitutions.size(), std::string::npos);
+    compiledExpressions->geneDependents.resize(genomeSize);
+    m_SubstitutionChanged.assign(m_SmartSubstitutions.size(), 0);
+    m_ChangedSubstitutions.clear();
 
-        if (success)
+    exprtk::parser<double> parser;
+    for (size_t i = 0; i < m_SmartSubstitutions.size(); i++)
+    {
+        const Substitution &substitution = m_SmartSubstitutions[i];
+        if (substitution.type == ConstantSubstitution) // already set in ClassifyExpressions
         {
-            m_SmartSubstitutionValues[i] = expression.value();
-//            std::cerr << "substitution value " << i << " = " << m_SmartSubstitutionValues[i] << "\n";
+            compiledExpressions->bytecode.AddConstant(m_SmartSubstitutionValues[i], i);
+            continue;
+        }
+        if (substitution.dependsOnAllGenes) compiledExpressions->allGeneDependents.push_back(i);
+        for (auto &&locus : substitution.dependencies)
+            if (locus < genomeSize) compiledExpressions->geneDependents[locus].push_back(i);
+        if (substitution.locus < genomeSize) // out of range loci are left to exprtk
+        {
+            if (substitution.type == DirectSubstitution)
+            {
+                compiledExpressions->directEntries.push_back({i, substitution.locus});
+                compiledExpressions->bytecode.AddGene(substitution.locus, i);
+                continue;
+            }
+            if (substitution.type == AffineSubstitution)
+            {
+                compiledExpressions->bytecode.AddAffine(substitution.locus, substitution.scale, substitution.offset, substitution.divide, i);
+                if (substitution.divide) compiledExpressions->divideEntries.push_back({i, substitution.locus, substitution.scale, substitution.offset});
+                else compiledExpressions->multiplyEntries.push_back({i, substitution.locus, substitution.scale, substitution.offset});
+                continue;
+            }
+        }
+        compiledExpressions->expressions.emplace_back();
+        exprtk::expression<double> &expression = compiledExpressions->expressions.back();
+        expression.register_symbol_table(compiledExpressions->symbolTable);
+        if (parser.compile(m_SmartSubstitutionParserText[i], expression))
+        {
+            compiledExpressions->substitutionExpressionIndices[i] = compiledExpressions->expressions.size() - 1;
+            compiledExpressions->expressionValueIndices.push_back(i);
+            if (!compiledExpressions->bytecode.AddExpression(m_SmartSubstitutionParserText[i], genomeSize, EvaluateConstant, i))
+                compiledExpressions->batchEntries.push_back({i, compiledExpressions->expressions.size() - 1});
         }
         else
         {
+            compiledExpressions->expressions.pop_back();
+            m_SmartSubstitutionValues[i] = 0;
+            compiledExpressions->bytecode.AddConstant(0, i);
             std::cerr << "Error: XMLConverter::ApplyGenome m_SmartSubstitutionParserComponents[" << i << "] does not evaluate to a number\n";
             std::cerr << "Applying standard fix up and setting to zero\n";
-            m_SmartSubstitutionValues[i] = 0;
         }
     }
+}
 
-    return 0;
+// recognises these forms where n is an integer and a and b are numbers
+//     g[n]                                     direct
+//     -g[n] a*g[n] g[n]*a g[n]/a               affine
+//     any of those followed by +b or -b        affine
+//     b+ or b- followed by any of those        affine
+// and expressions that do not use g at all are evaluated now
+// the arithmetic is rearranged only in ways that give exactly the same doubles as exprtk
+void XMLConverter::ClassifyExpressions()
+{
+    m_SmartSubstitutions.assign(m_SmartSubstitutionParserText.size(), Substitution());
+    std::vector<SubstitutionToken> tokens;
+    for (size_t i = 0; i < m_SmartSubstitutionParserText.size(); i++)
+    {
+        Substitution &substitution = m_SmartSubstitutions[i];
+        const std::string &text = m_SmartSubstitutionParserText[i];
+        bool tokenised = TokeniseSubstitution(text, &tokens);
+        bool usesGenome = std::any_of(tokens.begin(), tokens.end(), [](const SubstitutionToken &token) { return token.type == 'g'; });
+        if (!tokenised || !usesGenome)
+        {
+            // exprtk does the constant folding and fails if g or any other variable is used
+            if (EvaluateConstant(text, &m_SmartSubstitutionValues[i])) substitution.type = ConstantSubstitution;
+            continue;
+        }
+
+        // the optional leading b+ or b-
+        size_t first = 0, last = tokens.size();
+        bool negate = false;
+        bool hasOffset = false;
+        std::string offsetText;
+        bool negateOffset = false;
+        if (last - first > 2 && tokens[first].type == 'n' && (tokens[first + 1].type == '+' || tokens[first + 1].type == '-'))
+        {
+            hasOffset = true;
+            offsetText = tokens[first].text;
+            negate = tokens[first + 1].type == '-';
+            first += 2;
+        }
+        // or the optional trailing +b or -b
+        else if (last - first > 2 && tokens[last - 1].type == 'n' && (tokens[last - 2].type == '+' || tokens[last - 2].type == '-'))
+        {
+            hasOffset = true;
+            offsetText = tokens[last - 1].text;
+            negateOffset = tokens[last - 2].type == '-';
+            last -= 2;
+        }
+        // the optional unary minus
+        if (last - first > 1 && tokens[first].type == '-')
+        {
+            negate = !negate;
+            first++;
+        }
+        // the optional leading a*
+        std::string scaleText;
+        bool divide = false;
+        if (last - first > 2 && tokens[first].type == 'n' && tokens[first + 1].type == '*')
+        {
+            scaleText = tokens[first].text;
+            first += 2;
+        }
+        // or the optional trailing *a or /a
+        else if (last - first > 2 && tokens[last - 1].type == 'n' && (tokens[last - 2].type == '*' || tokens[last - 2].type == '/'))
+        {
+            scaleText = tokens[last - 1].text;
+            divide = tokens[last - 2].type == '/';
+            last -= 2;
+        }
+        // which must leave g[n]
+        if (last - first != 4 || tokens[first].type != 'g' || tokens[first + 1].type != '[' || tokens[first + 2].type != 'n' || tokens[first + 3].type != ']') continue;
+        const std::string &locusText = tokens[first + 2].text;
+        if (locusText.find_first_not_of("0123456789") != std::string::npos || locusText.size() > 9) continue;
+
+        double scale = 1, offset = -0.0;
+        if (scaleText.size() && !EvaluateConstant(scaleText, &scale)) continue;
+        if (hasOffset && !EvaluateConstant(offsetText, &offset)) continue;
+        // exprtk simplifies things like 0*x, x/0 and 0-x in ways that change the sign of zero
+        // or give nan so these are left to exprtk
+        if (scale == 0 || (hasOffset && offset == 0)) continue;
+        // -(g*a) == g*(-a), -(g/a) == g/(-a) and x-b == x+(-b) exactly
+        if (negate) scale = -scale;
+        if (negateOffset) offset = -offset;
+        substitution.locus = size_t(std::stoul(locusText));
+        substitution.scale = scale;
+        substitution.offset = offset;
+        substitution.divide = divide;
+        substitution.type = (scaleText.empty() && !negate && !hasOffset) ? DirectSubstitution : AffineSubstitution;
+    }
+}
+
+// find the loci that each substitution reads
+// exprtk names are not case sensitive and anything other than g[n] means it could read any locus
+void XMLConverter::FindDependencies()
+{
+    auto isNameCharacter = [](char c) { return isalpha(static_cast<unsigned char>(c)) || c == '_'; };
+    for (size_t i = 0; i < m_SmartSubstitutions.size(); i++)
+    {
+        Substitution &substitution = m_SmartSubstitutions[i];
+        substitution.dependencies.clear();
+        substitution.dependsOnAllGenes = false;
+        if (substitution.type == ConstantSubstitution) continue;
+        if (substitution.type == DirectSubstitution || substitution.type == AffineSubstitution)
+        {
+            substitution.dependencies.push_back(substitution.locus);
+            continue;
+        }
+        const std::string &text = m_SmartSubstitutionParserText[i];
+        for (size_t j = 0; j < text.size() && !substitution.dependsOnAllGenes; j++)
+        {
+            if (text[j] != 'g' && text[j] != 'G') continue;
+            if (j > 0 && isNameCharacter(text[j - 1])) continue; // part of a longer name
+            size_t k = j + 1;
+            if (k < text.size() && (isNameCharacter(text[k]) || isdigit(static_cast<unsigned char>(text[k])))) continue; // part of a longer name
+            substitution.dependsOnAllGenes = true; // until it is shown to be g[n]
+            if (j > 0 && (isdigit(static_cast<unsigned char>(text[j - 1])) || text[j - 1] == '.')) break; // could be a name or 2g
+            while (k < text.size() && text[k] < 33) k++;
+            if (k >= text.size() || text[k] != '[') break;
+            k++;
+            while (k < text.size() && text[k] < 33) k++;
+            size_t start = k;
+            while (k < text.size() && isdigit(static_cast<unsigned char>(text[k]))) k++;
+            if (k == start || k - start > 9) break;
+            size_t locus = size_t(std::stoul(text.substr(start, k - start)));
+            while (k < text.size() && text[k] < 33) k++;
+            if (k >= text.size() || text[k] != ']') break;
+            substitution.dependencies.push_back(locus);
+            substitution.dependsOnAllGenes = false;
+            j = k;
+        }
+        if (substitution.dependsOnAllGenes) substitution.dependencies.clear();
+    }
 }
 
 // exprtk requires [] around vector indices whereas my parser used ()
@@ -12,6 +12,7 @@
 
 #include <vector>
 #include <string>
+#include <memory>
 
 class Genome;
 class DataFile;
@@ -21,22 +22,60 @@ class XMLConverter
 {
 public:
     XMLConverter();
+    ~XMLConverter();
 
     int LoadBaseXMLFile(const char *filename);
     int LoadBaseXMLString(const char *dataPtr, size_t length);
     int ApplyGenome(int genomeSize, double *genomeData);
+    int ApplyGenomeChanges(int genomeSize, double *genomeData, const size_t *changedGenes, size_t numChangedGenes);
+    int ApplyGenomes(int genomeSize, size_t numGenomes, const double *genes, size_t geneStride, double *values, size_t valueStride);
     void GetFormattedXML(std::string *formattedXML);
+    size_t GetFormattedXML(char *buffer, size_t bufferSize);
+    int WriteFormattedXML(int fileDescriptor);
 
     const std::string &BaseXMLString() const;
+    size_t GetNumSubstitutions() const;
 
     void Clear();
 
 private:
 
     void ConvertVectorBrackets();
+    void ClassifyExpressions();
+    void CompileExpressions(size_t genomeSize);
+    void FindDependencies();
+    double EvaluateSubstitution(size_t i, const double *genomeData);
+    void UpdateFormattedXML();
+
+    // simple substitutions are evaluated directly and only the rest go through exprtk
+    enum SubstitutionType { GeneralSubstitution, ConstantSubstitution, DirectSubstitution, AffineSubstitution };
+    struct Substitution
+    {
+        SubstitutionType type = GeneralSubstitution;
+        size_t locus = 0;
+        double scale = 1; // affine value is g[locus] * scale + offset (or g[locus] / scale + offset)
+        double offset = -0.0; // adding -0.0 leaves every value unchanged including -0.0
+        bool divide = false;
+        std::vector<size_t> dependencies; // the loci that are read
+        bool dependsOnAllGenes = false; // when the loci cannot be found from the text
+    };
+    std::vector<Substitution> m_SmartSubstitutions;
+
+    // the last formatted output and where each value is in it so changed values can be patched in
+    std::string m_FormattedXML;
+    std::vector<size_t> m_FormattedValueOffsets;
+    std::vector<size_t> m_FormattedValueLengths;
+    std::vector<size_t> m_ChangedSubstitutions;
+    std::vector<char> m_SubstitutionChanged;
+    bool m_FormattedXMLValid = false;
+
+    // the exprtk objects are kept out of this header because exprtk.hpp is very large
+    struct CompiledExpressions;
+    std::unique_ptr<CompiledExpressions> m_CompiledExpressions;
 
     std::string m_BaseXMLString;
     std::vector<std::string> m_SmartSubstitutionTextComponents;
+    size_t m_SmartSubstitutionTextLength = 0;
     std::vector<std::string> m_SmartSubstitutionParserText;
     std::vector<double> m_SmartSubstitutionValues;
 };
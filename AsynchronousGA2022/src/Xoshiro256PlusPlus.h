@@ -0,0 +1,100 @@
+/*
+ *  Xoshiro256PlusPlus.h
+ *  AsynchronousGA
+ *
+ *  Created by Bill Sellers on 19/10/2026.
+ *  Copyright 2026 Bill Sellers. All rights reserved.
+ *
+ */
+
+#ifndef XOSHIRO256PLUSPLUS_H
+#define XOSHIRO256PLUSPLUS_H
+
+#include <cstdint>
+#include <limits>
+
+// xoshiro256++ by David Blackman and Sebastiano Vigna (http://prng.di.unimi.it)
+// A small and very fast 64 bit generator with a period of 2^256 - 1. Jump advances the state
+// by 2^128 steps and LongJump by 2^192 steps so that each thread can have its own stream
+// that will not overlap any of the others. It meets the requirements of a standard
+// UniformRandomBitGenerator so it can be used with the <random> distributions.
+class Xoshiro256PlusPlus
+{
+public:
+    typedef uint64_t result_type;
+
+    Xoshiro256PlusPlus() { seed(0); }
+    explicit Xoshiro256PlusPlus(uint64_t value) { seed(value); }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    // the state is filled using splitmix64 as recommended by the authors
+    // so that similar seeds still give unrelated streams
+    void seed(uint64_t value)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            value += 0x9E3779B97F4A7C15ULL;
+            uint64_t z = value;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            m_s[i] = z ^ (z >> 31);
+        }
+    }
+
+    result_type operator()()
+    {
+        const uint64_t result = Rotl(m_s[0] + m_s[3], 23) + m_s[0];
+        const uint64_t t = m_s[1] << 17;
+        m_s[2] ^= m_s[0];
+        m_s[3] ^= m_s[1];
+        m_s[1] ^= m_s[2];
+        m_s[0] ^= m_s[3];
+        m_s[2] ^= t;
+        m_s[3] = Rotl(m_s[3], 45);
+        return result;
+    }
+
+    void Jump()
+    {
+        static const uint64_t jump[] = { 0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL, 0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL };
+        ApplyJump(jump);
+    }
+
+    void LongJump()
+    {
+        static const uint64_t longJump[] = { 0x76E15D3EFEFDCBBFULL, 0xC5004E441C522FB3ULL, 0x77710069854EE241ULL, 0x39109BB02ACBE635ULL };
+        ApplyJump(longJump);
+    }
+
+private:
+    static inline uint64_t Rotl(const uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    void ApplyJump(const uint64_t *polynomial)
+    {
+        uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            for (int b = 0; b < 64; b++)
+            {
+                if (polynomial[i] & (uint64_t(1) << b))
+                {
+                    s0 ^= m_s[0];
+                    s1 ^= m_s[1];
+                    s2 ^= m_s[2];
+                    s3 ^= m_s[3];
+                }
+                (*this)();
+            }
+        }
+        m_s[0] = s0;
+        m_s[1] = s1;
+        m_s[2] = s2;
+        m_s[3] = s3;
+    }
+
+    uint64_t m_s[4];
+};
+
+#endif // XOSHIRO256PLUSPLUS_H
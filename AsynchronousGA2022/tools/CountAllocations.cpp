@@ -0,0 +1,58 @@
+/*
+ *  CountAllocations.cpp
+ *  AsynchronousGA
+ *
+ *  Created by Bill Sellers on 19/10/2026.
+ *  Copyright 2026 Bill Sellers. All rights reserved.
+ *
+ */
+
+// Linked into the allocation_check build of the GA. It replaces the global operator new
+// so that every heap allocation is counted and the total is written to stderr at exit.
+// The array and nothrow forms call these so they are counted too.
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+
+std::atomic<unsigned long long> allocationCount(0);
+
+void ReportAllocations()
+{
+    std::fprintf(stderr, "allocations %llu\n", allocationCount.load());
+}
+
+struct AllocationReporter
+{
+    AllocationReporter() { std::atexit(ReportAllocations); }
+} allocationReporter;
+
+}
+
+void *operator new(std::size_t size)
+{
+    allocationCount++;
+    if (size == 0) size = 1;
+    if (void *ptr = std::malloc(size)) return ptr;
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+    allocationCount++;
+    std::size_t align = std::size_t(alignment);
+    if (align < sizeof(void *)) align = sizeof(void *);
+    void *ptr = nullptr;
+    if (size == 0) size = 1;
+    if (posix_memalign(&ptr, align, size) == 0) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
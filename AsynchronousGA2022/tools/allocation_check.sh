@@ -0,0 +1,87 @@
+#!/bin/sh
+# Runs the allocation_check build of the GA over two synthetic --replay logs that differ only in length
+# and reports the extra heap allocations per extra genome. The evolve loop is meant to reuse its storage
+# so this should stay well below one. The progress line every 100 returns still allocates.
+# usage: allocation_check.sh bin/AsynchronousGA2022_allocation_check [genomes]
+
+BINARY=$1
+GENOMES=${2:-10000}
+LIMIT=0.1
+if [ -z "$BINARY" ] || [ ! -x "$BINARY" ]; then
+    echo "usage: $0 allocation_check_binary [genomes]" >&2
+    exit 1
+fi
+WORK=$(mktemp -d) || exit 1
+trap 'rm -rf "$WORK"' EXIT
+
+cat > "$WORK/parameters.txt" <<PARAMETERS
+genomeLength 5
+populationSize 50
+maxReproductions 1000000000
+gaussianMutationChance 0.5
+frameShiftMutationChance 0
+duplicationMutationChance 0
+crossoverChance 0.5
+parentsToKeep 5
+saveBestEvery 1000000000
+savePopEvery 1000000000
+outputStatsEvery 1000000000
+onlyKeepBestGenome true
+onlyKeepBestPopulation true
+improvementReproductions 1000000000
+improvementThreshold 0
+multipleGaussian false
+randomiseModel false
+outputPopulationSize 50
+watchDogTimerLimit 1000
+parentSelection RankBasedSelection
+gamma 1
+crossoverType OnePoint
+circularMutation false
+bounceMutation false
+resizeControl MutateResize
+PARAMETERS
+
+echo '<model a="[[g(0)]]" b="[[g(1)*2+g(2)]]" c="[[sqrt(g(3))]]" d="[[g(4)]]"/>' > "$WORK/base.xml"
+
+awk 'BEGIN {
+    srand(1);
+    print 50;
+    for (i = 0; i < 50; i++) {
+        print -1; print 5;
+        for (j = 0; j < 5; j++) printf "%.17g\t0\t1\t0.1\n", rand();
+        print "0\t0\t0\t0\t0";
+    }
+}' > "$WORK/population.txt"
+
+# one request and its score at a time with runIDs in the order the genomes are sent
+MakeLog()
+{
+    awk -v count="$1" 'BEGIN {
+        srand(2);
+        print "AsynchronousGA2022 event log 1";
+        print "randomSeed 1";
+        for (i = 0; i < count; i++) { print "request 1 1"; printf "score %d %.17g\n", i, rand(); }
+    }' > "$2"
+}
+
+CountAllocations()
+{
+    MakeLog "$1" "$WORK/log$1.txt"
+    "$BINARY" --parameterFile "$WORK/parameters.txt" --baseXMLFile "$WORK/base.xml" --startingPopulation "$WORK/population.txt" \
+        --outputDirectory "$WORK/output$1" --replay "$WORK/log$1.txt" 2>&1 >/dev/null | awk '$1 == "allocations" { print $2 }'
+}
+
+FIRST=$(CountAllocations "$GENOMES")
+SECOND=$(CountAllocations $((GENOMES * 2)))
+if [ -z "$FIRST" ] || [ -z "$SECOND" ]; then
+    echo "Error: the allocation count was not reported" >&2
+    exit 1
+fi
+echo "$GENOMES genomes: $FIRST allocations"
+echo "$((GENOMES * 2)) genomes: $SECOND allocations"
+awk -v first="$FIRST" -v second="$SECOND" -v genomes="$GENOMES" -v limit="$LIMIT" 'BEGIN {
+    perGenome = (second - first) / genomes;
+    printf "%.4f allocations per genome (limit %g)\n", perGenome, limit;
+    exit (perGenome < limit) ? 0 : 1;
+}'